@@ -0,0 +1,51 @@
+﻿///
+/// 追加の較正板の配置の実装
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 19, 2026
+///
+#include "BoardLayout.h"
+
+// 標準ライブラリ
+#include <string>
+#include <algorithm>
+
+//
+// 構成ファイルを読み込むときに使うコンストラクタ
+//
+BoardLayout::BoardLayout(const picojson::object& object)
+  : BoardLayout{}
+{
+  // 較正板の種類
+  std::string name;
+  if (getString(object, "type", name)) type = name == "grid" ? Type::GRID : Type::CHARUCO;
+
+  // マス目またはマーカの数
+  getValue(object, "size", size);
+  for (auto& n : size) n = std::max(n, type == Type::CHARUCO ? 3 : 1);
+
+  // マス目とマーカの一辺の長さまたはマーカの一辺の長さと間隔 (較正板を作れなければデフォルト値にする)
+  getValue(object, "length", length);
+  if (!hasValidLength()) length = BoardLayout{}.length;
+
+  // 使用する ArUco Marker の最初の番号 (負なら直前の較正板の次の番号から使う)
+  getValue(object, "first", firstId);
+  firstId = std::max(firstId, -1);
+}
+
+//
+// 構成ファイルに保存する JSON オブジェクトを得る
+//
+picojson::object BoardLayout::getObject() const
+{
+  // 構成ファイルの JSON オブジェクト
+  picojson::object object;
+
+  setString(object, "type", type == Type::GRID ? "grid" : "charuco");
+  setValue(object, "size", size);
+  setValue(object, "length", length);
+  setValue(object, "first", firstId);
+
+  return object;
+}
@@ -0,0 +1,98 @@
+﻿#pragma once
+
+///
+/// 追加の較正板の配置の定義
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 19, 2026
+///
+
+// 構成ファイルの読み取り補助
+#include "parseconfig.h"
+
+// 標準ライブラリ
+#include <array>
+
+///
+/// 追加の較正板の配置
+///
+/// @description
+/// 選択している ChArUco Board とは別に同時に検出する較正板の種類と大きさと
+/// 使用する ArUco Marker の番号の範囲を保持する。
+/// ArUco Marker の辞書は選択している ChArUco Board と共通なので、
+/// 番号の範囲は較正板ごとに重ならないようにする (重なる較正板は作成しない)。
+///
+struct BoardLayout
+{
+  ///
+  /// 較正板の種類
+  ///
+  enum class Type : int
+  {
+    /// ChArUco Board
+    CHARUCO = 0,
+
+    /// ArUco Marker を格子状に並べた GridBoard (AprilTag の辞書なら AprilGrid 相当)
+    GRID = 1
+  };
+
+  /// 較正板の種類
+  Type type;
+
+  /// ChArUco Board なら横と縦のマス目の数, GridBoard なら横と縦のマーカの数
+  std::array<int, 2> size;
+
+  /// ChArUco Board ならマス目とマーカの一辺の長さ, GridBoard ならマーカの一辺の長さと間隔 (単位 cm)
+  std::array<float, 2> length;
+
+  /// 使用する ArUco Marker の最初の番号, 負なら直前の較正板が使う番号の次から使う
+  int firstId;
+
+  ///
+  /// デフォルトコンストラクタ
+  ///
+  BoardLayout()
+    : type{ Type::CHARUCO }
+    , size{ 5, 4 }
+    , length{ 4.0f, 2.0f }
+    , firstId{ -1 }
+  {
+  }
+
+  ///
+  /// 構成ファイルを読み込むときに使うコンストラクタ
+  ///
+  /// @param object 構成ファイルの JSON オブジェクト
+  ///
+  BoardLayout(const picojson::object& object);
+
+  ///
+  /// 構成ファイルに保存する JSON オブジェクトを得る
+  ///
+  /// @return 構成ファイルの JSON オブジェクト
+  ///
+  picojson::object getObject() const;
+
+  ///
+  /// 較正板に使う ArUco Marker の数を得る
+  ///
+  /// @return 較正板に使う ArUco Marker の数
+  ///
+  int getMarkerCount() const
+  {
+    return type == Type::CHARUCO ? size[0] * size[1] / 2 : size[0] * size[1];
+  }
+
+  ///
+  /// 長さが較正板を作成できる値か調べる
+  ///
+  /// @return ChArUco Board ならマーカがマス目より小さく, GridBoard なら間隔も含めてどちらも正なら true
+  ///
+  bool hasValidLength() const
+  {
+    return type == Type::CHARUCO
+      ? length[1] > 0.0f && length[1] < length[0]
+      : length[0] > 0.0f && length[1] > 0.0f;
+  }
+};
@@ -63,6 +63,11 @@ void Buffer::create(GLsizei width, GLsizei height, int channels)
   if (width == bufferSize[0] && height == bufferSize[1]
     && channels == bufferChannels) return;
 
+#if defined(USE_PIXEL_BUFFER_OBJECT)
+  // 以前のピクセルバッファオブジェクトは再利用できるように戻す
+  ResourcePool::releaseBuffer(bufferName, bufferLength);
+#endif
+
   // フレームのサイズとチャンネル数を記録する
   bufferSize = std::array<int, 2>{ width, height };
   bufferChannels = channels;
@@ -71,16 +76,8 @@ void Buffer::create(GLsizei width, GLsizei height, int channels)
   bufferLength = width * height * channels;
 
 #if defined(USE_PIXEL_BUFFER_OBJECT)
-  // 以前のピクセルバッファオブジェクトを破棄する
-  glDeleteBuffers(1, &bufferName);
-
-  // 新しいピクセルバッファオブジェクトを作成する
-  glGenBuffers(1, &bufferName);
-
-  // ピクセルバッファオブジェクトのメモリを確保してデータを転送する
-  glBindBuffer(GL_PIXEL_PACK_BUFFER, bufferName);
-  glBufferData(GL_PIXEL_PACK_BUFFER, bufferLength, nullptr, GL_DYNAMIC_COPY);
-  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+  // 同じデータ長のピクセルバッファオブジェクトを取り出すか新しく作る
+  bufferName = ResourcePool::acquireBuffer(bufferLength);
 #else
   // メモリを確保する
   bufferName.resize(size);
@@ -124,11 +121,18 @@ Buffer& Buffer::operator=(Buffer&& buffer) noexcept
   // 代入元と代入先が同じでなければ
   if (&buffer != this)
   {
-    // 引数のバッファをバッファをこのバッファにコピーする
-    Buffer::copy(buffer);
+    // このバッファを破棄して
+    Buffer::discard();
 
-    // 引数のバッファを破棄する
-    buffer.Buffer::discard();
+    // ムーブ元のピクセルバッファオブジェクトを引き継ぎ、ムーブ元は空にする
+    bufferSize = std::exchange(buffer.bufferSize, std::array<int, 2>{ 0, 0 });
+    bufferChannels = std::exchange(buffer.bufferChannels, 0);
+#if defined(USE_PIXEL_BUFFER_OBJECT)
+    bufferLength = std::exchange(buffer.bufferLength, 0);
+    bufferName = std::exchange(buffer.bufferName, 0);
+#else
+    bufferName = std::move(buffer.bufferName);
+#endif
   }
 
   // このバッファを返す
@@ -180,9 +184,10 @@ void Buffer::discard()
   glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
   glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
 
-  // ピクセルバッファオブジェクトを削除する
-  glDeleteBuffers(1, &bufferName);
+  // ピクセルバッファオブジェクトを再利用できるように戻す
+  ResourcePool::releaseBuffer(bufferName, bufferLength);
   bufferName = 0;
+  bufferLength = 0;
 #else
   // メモリを消去する
   bufferName.clear();
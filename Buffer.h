@@ -12,9 +12,33 @@
 #include "gg.h"
 using namespace gg;
 
+// GPU の資源の再利用
+#include "ResourcePool.h"
+
+// 標準ライブラリ
+#include <utility>
+
 // ピクセルバッファオブジェクトを使うとき
 #define USE_PIXEL_BUFFER_OBJECT
 
+///
+/// フレームの画素の格納形式
+///
+/// @note
+/// 値は展開用シェーダの uniform 変数 format に設定する。
+///
+enum class FrameFormat : GLint
+{
+  /// 画素ごとにチャネルを並べた形式 (BGR など)
+  INTERLEAVED = 0,
+
+  /// 横２画素ごとに輝度と色差を Y0 U Y1 V の順に並べた形式
+  YUYV = 1,
+
+  /// 輝度の平面の後に横２画素×縦２画素ごとの色差 U V を並べた平面を置く形式
+  NV12 = 2
+};
+
 ///
 /// バッファクラス
 ///
@@ -58,6 +82,21 @@ protected:
     return toFormat[(channels - 1) & 3];
   }
 
+  ///
+  /// チャネル数からテクスチャの内部フォーマットを求める
+  ///
+  /// @param channels フレームのチャネル数
+  /// @return チャネルあたり 8 bit のテクスチャの内部フォーマット
+  ///
+  auto channelsToInternalFormat(int channels) const
+  {
+    // OpenGL のテクスチャの内部フォーマットのリスト
+    static constexpr GLenum toInternalFormat[]{ GL_R8, GL_RG8, GL_RGB8, GL_RGBA8 };
+
+    // 内部フォーマットを返す
+    return toInternalFormat[(channels - 1) & 3];
+  }
+
   ///
   /// フォーマットからチャネル数を求める
   ///
@@ -100,6 +139,7 @@ public:
   /// そこにフレームのデータを格納する。
   ///
   Buffer(GLsizei width, GLsizei height, int channels)
+    : Buffer{}
   {
     Buffer::create(width, height, channels);
   }
@@ -110,6 +150,7 @@ public:
   /// @param texture コピー元のバッファ
   ///
   Buffer(const Buffer& buffer)
+    : Buffer{}
   {
     Buffer::copy(buffer);
   }
@@ -119,9 +160,20 @@ public:
   ///
   /// @param texture ムーブ元のバッファ
   ///
+  /// @note
+  /// ムーブ元のピクセルバッファオブジェクトを引き継ぐので、
+  /// GPU 上でのコピーやメモリの確保は行わない。ムーブ元は空になる。
+  ///
   Buffer(Buffer&& buffer) noexcept
+    : bufferSize{ std::exchange(buffer.bufferSize, std::array<int, 2>{ 0, 0 }) }
+    , bufferChannels{ std::exchange(buffer.bufferChannels, 0) }
+#if defined(USE_PIXEL_BUFFER_OBJECT)
+    , bufferLength{ std::exchange(buffer.bufferLength, 0) }
+    , bufferName{ std::exchange(buffer.bufferName, 0) }
+#else
+    , bufferName{ std::move(buffer.bufferName) }
+#endif
   {
-    *this = std::move(buffer);
   }
 
   ///
@@ -146,6 +198,9 @@ public:
   /// @param buffer ムーブ代入元のバッファ
   /// @return ムーブ代入結果のバッファ
   ///
+  /// @note
+  /// このバッファを破棄してムーブ元のピクセルバッファオブジェクトを引き継ぐ。
+  ///
   Buffer& operator=(Buffer&& buffer) noexcept;
 
   ///
@@ -157,7 +212,8 @@ public:
   ///
   /// @note
   /// このバッファのサイズが引数で指定したサイズと異なれば、
-  /// このバッファを削除して新しいバッファを作り直す。
+  /// このバッファを ResourcePool に戻して、
+  /// 同じデータ長のバッファを取り出すか新しく作る。
   ///
   virtual void create(GLsizei width, GLsizei height, int channels);
 
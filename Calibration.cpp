@@ -7,24 +7,139 @@
 ///
 #include "Calibration.h"
 
-// 構成ファイルの読み取り補助
-#include "parseconfig.h"
-
 // OpenCV
 #include <opencv2/calib3d.hpp>
+#include <opencv2/imgproc.hpp>
 
 // 標準ライブラリ
+#include <algorithm>
 #include <fstream>
+#include <limits>
 #include <numeric>
+#include <utility>
 
 // cv::Rodrigues() を使う
 #define USE_RODRIGUES
 
+//
+// ArUco Marker の検出の設定から検出器のパラメータを作る
+//
+static cv::aruco::DetectorParameters toDetectorParameters(const DetectorSettings& settings)
+{
+  cv::aruco::DetectorParameters params;
+  params.adaptiveThreshWinSizeMin = settings.adaptiveThreshWinSize[0];
+  params.adaptiveThreshWinSizeMax = settings.adaptiveThreshWinSize[1];
+  params.adaptiveThreshWinSizeStep = settings.adaptiveThreshWinSize[2];
+  params.cornerRefinementMethod = settings.cornerRefinementMethod;
+  params.minMarkerPerimeterRate = settings.minMarkerPerimeterRate;
+  params.useAruco3Detection = settings.useAruco3Detection;
+  params.minSideLengthCanonicalImg = settings.minSideLengthCanonicalImg;
+  params.cameraMotionSpeed = settings.cameraMotionSpeed;
+
+  // 最初のフレームは元の画像全体から探す
+  params.minMarkerLengthRatioOriginalImg = 0.0f;
+  return params;
+}
+
+//
+// 検出の設定からコーナーのサブピクセル精度の補正の終了条件を作る
+//
+static cv::TermCriteria toSubPixelCriteria(const DetectorSettings& settings)
+{
+  return cv::TermCriteria{ cv::TermCriteria::COUNT | cv::TermCriteria::EPS,
+    std::max(settings.subPixelIterations, 1), 0.01 };
+}
+
+//
+// 画像の一部を濃淡画像にする
+//
+static void toGray(const cv::Mat& src, cv::Mat& dst)
+{
+  switch (src.channels())
+  {
+  case 4:
+    cv::cvtColor(src, dst, cv::COLOR_BGRA2GRAY);
+    break;
+  case 3:
+    cv::cvtColor(src, dst, cv::COLOR_BGR2GRAY);
+    break;
+  default:
+    src.copyTo(dst);
+    break;
+  }
+}
+
+//
+// コーナーの位置をその周囲の小さな領域でサブピクセル精度に補正する
+//
+static void refineCorners(const cv::Mat& image, std::vector<cv::Point2f>& corners,
+  int window, const cv::TermCriteria& criteria)
+{
+  // 補正しないか補正するコーナーがなければ何もしない
+  if (window <= 0 || corners.empty()) return;
+
+  // コーナーの周囲から切り出す領域の大きさの半分は補正で移動する範囲を含める
+  const int radius{ window * 2 + 1 };
+
+  // cv::cornerSubPix() が必要とする領域の大きさの最小値
+  const int minimum{ window * 2 + 5 };
+
+  // 画像全体の領域
+  const cv::Rect bounds{ 0, 0, image.cols, image.rows };
+
+  // コーナーごとに並列に補正する
+  cv::parallel_for_(cv::Range{ 0, static_cast<int>(corners.size()) }, [&](const cv::Range& range)
+  {
+    // 切り出した領域の濃淡画像と補正するコーナー
+    cv::Mat gray;
+    std::vector<cv::Point2f> point(1);
+
+    for (int i = range.start; i < range.end; ++i)
+    {
+      // コーナーの周囲の領域を画像の内側で切り出す
+      const cv::Point center{ cvRound(corners[i].x), cvRound(corners[i].y) };
+      const cv::Rect roi{ cv::Rect{ center.x - radius, center.y - radius, radius * 2 + 1, radius * 2 + 1 } & bounds };
+      if (roi.width < minimum || roi.height < minimum) continue;
+      toGray(image(roi), gray);
+
+      // 切り出した領域の中でコーナーの位置を補正する
+      const cv::Point2f origin(roi.tl());
+      point[0] = corners[i] - origin;
+      cv::cornerSubPix(gray, point, cv::Size{ window, window }, cv::Size{ -1, -1 }, criteria);
+
+      // 補正で窓の外まで移動したコーナーは別のコーナーに引き寄せられたとみなして採用しない
+      const auto d{ point[0] + origin - corners[i] };
+      if (d.dot(d) <= static_cast<float>(window * window)) corners[i] = point[0] + origin;
+    }
+  });
+}
+
+//
+// デフォルトコンストラクタ
+//
+Calibration::Calibration()
+  : subPixelWindow{ 0 }
+  , squares{ 10, 7 }
+  , size{ 0, 0 }
+  , repError{ 0.0 }
+  , totalCorners{ 0 }
+  , calibrationFlags{ 0 }
+  , boardRevision{ 0 }
+  , boardKey{}
+  , markerKey{}
+{
+}
+
 //
 // コンストラクタ
 //
-Calibration::Calibration(const std::string& dictionaryName, const std::array<float, 2>& length)
-  : size{ 0, 0 }
+Calibration::Calibration(const std::string& dictionaryName, const std::array<float, 2>& length,
+  const std::array<int, 2>& squares, const DetectorSettings& detectorSettings)
+  : detectorParams{ toDetectorParameters(detectorSettings) }
+  , subPixelWindow{ detectorSettings.subPixelWindow }
+  , subPixelCriteria{ toSubPixelCriteria(detectorSettings) }
+  , squares{ squares }
+  , size{ 0, 0 }
   , repError{ 0.0 }
   , totalCorners{ 0 }
   , calibrationFlags
@@ -42,6 +157,9 @@ Calibration::Calibration(const std::string& dictionaryName, const std::array<flo
     //| cv::CALIB_TILTED_MODEL        // Coefficients tauX and tauY are enabled.To provide the backward compatibility, this extra flag should be explicitly specified to make the calibration function use the tilted sensor model and return 14 coefficients.
     //| cv::CALIB_FIX_TAUX_TAUY       // The coefficients of the tilted sensor model are not changed during the optimization.If CALIB_USE_INTRINSIC_GUESS is set, the coefficient from the supplied distCoeffs matrix is used.Otherwise, it is set to 0.
   }
+  , boardRevision{ 0 }
+  , boardKey{}
+  , markerKey{}
 {
   // ArUco Marker の辞書を選択する
   setDictionary(dictionaryName, length);
@@ -60,15 +178,21 @@ Calibration::~Calibration()
 void Calibration::createBoard(const std::array<float, 2>& length)
 {
   // キャリブレーション用の ChArUco Board を作成する
-  board = new cv::aruco::CharucoBoard(cv::Size{ 10, 7 },
+  board = new cv::aruco::CharucoBoard(cv::Size{ squares[0], squares[1] },
     length[0] * 0.01f, length[1] * 0.01f, dictionary);
 
   // キャリブレーション用の ChArUco Board の検出器を作成する
-  boardDetector = new cv::aruco::CharucoDetector(*board);
+  boardDetector = new cv::aruco::CharucoDetector(*board, cv::aruco::CharucoParameters{}, detectorParams);
 
   // board は boardDetector->getBoard() で取り出すことができるが
   // 実行中に board を作り直すことがあるので cv::Ptr に持たせる
 
+  // 追加の較正板も同じ辞書で作り直す
+  createExtraBoards();
+
+  // 検出結果を再利用しない
+  ++boardRevision;
+
   // 較正結果を再利用しない
   calibrationFlags &= ~cv::CALIB_USE_INTRINSIC_GUESS;
 }
@@ -88,13 +212,153 @@ void Calibration::setDictionary(const std::string& dictionaryName, const std::ar
   dictionary = cv::aruco::getPredefinedDictionary(dictionaryItem->second);
 
   // ArUco Marker の検出器を作成する
-  cv::aruco::DetectorParameters detectorParams = cv::aruco::DetectorParameters();
   detector = new cv::aruco::ArucoDetector(dictionary, detectorParams);
 
   // キャリブレーション用の ChArUco Board を作成する
   createBoard(length);
 }
 
+//
+// ArUco Marker の検出の設定を変更する
+//
+void Calibration::setDetector(const DetectorSettings& detectorSettings)
+{
+  // 検出器のパラメータを作る
+  detectorParams = toDetectorParameters(detectorSettings);
+
+  // ChArUco Board のコーナーのサブピクセル精度の補正の設定
+  subPixelWindow = detectorSettings.subPixelWindow;
+  subPixelCriteria = toSubPixelCriteria(detectorSettings);
+
+  // ArUco Marker の検出器を作り直す
+  detector = new cv::aruco::ArucoDetector(dictionary, detectorParams);
+
+  // ChArUco Board の検出器を作り直す
+  if (board) boardDetector = new cv::aruco::CharucoDetector(*board, cv::aruco::CharucoParameters{}, detectorParams);
+
+  // 追加の較正板の検出器も作り直す
+  createExtraBoards();
+
+  // 検出結果を再利用しない
+  ++boardRevision;
+}
+
+//
+// 追加の較正板を現在の辞書と検出器のパラメータで作成する
+//
+void Calibration::createExtraBoards()
+{
+  // 以前の追加の較正板を破棄する
+  extraBoards.clear();
+
+  // 辞書に含まれる ArUco Marker の数
+  const auto dictionarySize{ dictionary.bytesList.rows };
+
+  // 既に使っている ArUco Marker の番号の範囲 (最初は選択している ChArUco Board の番号)
+  const auto primaryCount{ board ? static_cast<int>(board->getIds().size()) : 0 };
+  std::vector<std::pair<int, int>> usedIds{ { 0, primaryCount } };
+
+  // 最初の番号を指定していない較正板が使う番号
+  auto nextId{ primaryCount };
+
+  // すべての配置について
+  for (const auto& layout : layouts)
+  {
+    // 較正板に使う ArUco Marker の番号
+    const auto firstId{ layout.firstId >= 0 ? layout.firstId : nextId };
+    const auto markerCount{ std::max(layout.getMarkerCount(), 0) };
+    std::vector<int> markerIds(markerCount);
+    std::iota(markerIds.begin(), markerIds.end(), firstId);
+
+    // 辞書にない番号を使うか長さが不正なら作らない
+    if (markerIds.empty() || markerIds.back() >= dictionarySize || !layout.hasValidLength()) continue;
+
+    // 先の較正板と番号の範囲が重なれば同じマーカが両方に振り分けられるので作らない
+    if (std::any_of(usedIds.begin(), usedIds.end(), [firstId, markerCount](const std::pair<int, int>& used)
+      { return firstId < used.second && used.first < firstId + markerCount; })) continue;
+    usedIds.emplace_back(firstId, firstId + markerCount);
+    nextId = firstId + markerCount;
+
+    // 追加の較正板 (マーカの振り分けに使うので最初の番号は求めたものにする)
+    ExtraBoard extra;
+    extra.layout = layout;
+    extra.layout.firstId = firstId;
+    const cv::Size boardSize{ layout.size[0], layout.size[1] };
+
+    if (layout.type == BoardLayout::Type::CHARUCO)
+    {
+      // 指定した番号の ArUco Marker を使う ChArUco Board とその検出器を作る
+      cv::Ptr<cv::aruco::CharucoBoard> charuco{ new cv::aruco::CharucoBoard(boardSize,
+        layout.length[0] * 0.01f, layout.length[1] * 0.01f, dictionary, markerIds) };
+      extra.detector = new cv::aruco::CharucoDetector(*charuco, cv::aruco::CharucoParameters{}, detectorParams);
+      extra.board = charuco;
+    }
+    else
+    {
+      // 指定した番号の ArUco Marker を格子状に並べた GridBoard を作る
+      extra.board = new cv::aruco::GridBoard(boardSize,
+        layout.length[0] * 0.01f, layout.length[1] * 0.01f, dictionary, markerIds);
+    }
+
+    extraBoards.emplace_back(std::move(extra));
+  }
+}
+
+//
+// 同時に検出する追加の較正板を設定する
+//
+size_t Calibration::setBoards(const std::vector<BoardLayout>& newLayouts)
+{
+  // 追加の較正板を作り直す
+  layouts = newLayouts;
+  createExtraBoards();
+
+  // 検出結果を再利用しない
+  ++boardRevision;
+
+  return extraBoards.size();
+}
+
+//
+// 最後の検出で見つかった追加の較正板の数を得る
+//
+int Calibration::getDetectedExtraBoardCount() const
+{
+  return static_cast<int>(std::count_if(extraBoards.begin(), extraBoards.end(),
+    [](const ExtraBoard& extra) { return !extra.markerIds.empty(); }));
+}
+
+//
+// 別の較正オブジェクトと同じ ArUco Marker の辞書と ChArUco Board を使う
+//
+void Calibration::shareBoard(const Calibration& calibration)
+{
+  // 既に同じ ChArUco Board と検出器と追加の較正板を使っていれば何もしない
+  if (board == calibration.board && boardDetector == calibration.boardDetector
+    && detector == calibration.detector
+    && std::equal(extraBoards.begin(), extraBoards.end(),
+      calibration.extraBoards.begin(), calibration.extraBoards.end(),
+      [](const ExtraBoard& a, const ExtraBoard& b) { return a.board == b.board; })) return;
+
+  // ArUco Marker の辞書と検出器と ChArUco Board とその検出器を共有する
+  dictionary = calibration.dictionary;
+  detector = calibration.detector;
+  detectorParams = calibration.detectorParams;
+  subPixelWindow = calibration.subPixelWindow;
+  subPixelCriteria = calibration.subPixelCriteria;
+  board = calibration.board;
+  squares = calibration.squares;
+  boardDetector = calibration.boardDetector;
+  layouts = calibration.layouts;
+  extraBoards = calibration.extraBoards;
+
+  // 検出結果を再利用しない
+  ++boardRevision;
+
+  // 較正結果を再利用しない
+  calibrationFlags &= ~cv::CALIB_USE_INTRINSIC_GUESS;
+}
+
 //
 // ChArUco Board を描く
 //
@@ -103,31 +367,171 @@ void Calibration::drawBoard(cv::Mat& boardImage, int width, int height)
   board->generateImage(cv::Size{ width, height }, boardImage, 10, 1);
 }
 
+//
+// 前回の検出結果を再利用できるか調べて検出結果を得る画像の鍵を記録する
+//
+bool Calibration::reuse(DetectionKey& key, unsigned long long sequence, unsigned int revision) const
+{
+  // 今回の画像の鍵
+  const DetectionKey current{ sequence, revision, boardRevision };
+
+  // 転送番号が有効で前回と同じ鍵なら再利用できる
+  const bool same{ sequence != 0 && current == key };
+
+  // 今回の鍵を記録する (転送番号が無効なら次も再利用しない)
+  key = sequence != 0 ? current : DetectionKey{};
+
+  return same;
+}
+
+//
+// ArUco3 で次のフレームの検出に用いるマーカの最小の大きさを更新する
+//
+void Calibration::updateMarkerLengthRatio(const std::vector<std::vector<cv::Point2f>>& markers,
+  const cv::Size& imageSize)
+{
+  // ArUco3 を使わないなら何もしない
+  if (!detectorParams.useAruco3Detection) return;
+
+  // マーカを検出できなければ次のフレームでは画像全体から探す
+  if (markers.empty())
+  {
+    detectorParams.minMarkerLengthRatioOriginalImg = 0.0f;
+    return;
+  }
+
+  // 検出したマーカの最も短い辺の長さを求める
+  auto minSide{ std::numeric_limits<float>::max() };
+  for (const auto& marker : markers)
+  {
+    for (size_t i = 0; i < marker.size(); ++i)
+    {
+      const auto side{ static_cast<float>(cv::norm(marker[i] - marker[(i + 1) % marker.size()])) };
+      minSide = std::min(minSide, side);
+    }
+  }
+
+  // カメラの動きでマーカが小さくなる分を見込んで画像の長辺に対する比率を求める
+  const auto longSide{ static_cast<float>(std::max(imageSize.width, imageSize.height)) };
+  detectorParams.minMarkerLengthRatioOriginalImg
+    = (1.0f - detectorParams.cameraMotionSpeed) * minSide / longSide;
+}
+
+//
+// 番号が指定した範囲にある ArUco Marker を選ぶ
+//
+static void selectMarkers(const std::vector<std::vector<cv::Point2f>>& markerCorners,
+  const std::vector<int>& markerIds, int first, int count,
+  std::vector<std::vector<cv::Point2f>>& selectedCorners, std::vector<int>& selectedIds)
+{
+  selectedCorners.clear();
+  selectedIds.clear();
+  for (size_t i = 0; i < markerIds.size(); ++i)
+  {
+    if (markerIds[i] >= first && markerIds[i] < first + count)
+    {
+      selectedCorners.emplace_back(markerCorners[i]);
+      selectedIds.emplace_back(markerIds[i]);
+    }
+  }
+}
+
 //
 // ChArUco Board を検出する
 //
-void Calibration::detectBoard(cv::Mat& image)
+void Calibration::detectBoard(cv::Mat& image, unsigned long long sequence, unsigned int revision)
 {
   // 画像のサイズを保存しておく
   size = image.size();
 
-  // ChArUco Board のコーナーを検出する
-  boardDetector->detectBoard(image, charucoCorners, charucoIds);
+  // 前回と同じ画像でなければ
+  if (!reuse(boardKey, sequence, revision))
+  {
+    // ArUco3 を使うなら前のフレームで求めたマーカの最小の大きさを検出器に設定する
+    if (detectorParams.useAruco3Detection) boardDetector->setDetectorParameters(detectorParams);
+
+    // 検出した ArUco Marker
+    std::vector<std::vector<cv::Point2f>> markerCorners;
+    std::vector<int> markerIds;
+
+    if (extraBoards.empty())
+    {
+      // ChArUco Board のコーナーを検出する
+      boardDetector->detectBoard(image, charucoCorners, charucoIds, markerCorners, markerIds);
+    }
+    else
+    {
+      // すべての較正板の ArUco Marker を一度に検出する
+      if (detectorParams.useAruco3Detection) detector->setDetectorParameters(detectorParams);
+      detector->detectMarkers(image, markerCorners, markerIds);
+
+      // 選択している ChArUco Board の ArUco Marker からコーナーを求める
+      std::vector<std::vector<cv::Point2f>> boardCorners;
+      std::vector<int> boardIds;
+      selectMarkers(markerCorners, markerIds, 0, static_cast<int>(board->getIds().size()),
+        boardCorners, boardIds);
+      charucoCorners.clear();
+      charucoIds.clear();
+      if (!boardIds.empty())
+        boardDetector->detectBoard(image, charucoCorners, charucoIds, boardCorners, boardIds);
+
+      // 追加の較正板ごとに
+      for (auto& extra : extraBoards)
+      {
+        // その較正板の番号の ArUco Marker を振り分ける
+        selectMarkers(markerCorners, markerIds, extra.layout.firstId, extra.layout.getMarkerCount(),
+          extra.markerCorners, extra.markerIds);
+
+        // ChArUco Board ならコーナーを求める
+        extra.charucoCorners.clear();
+        extra.charucoIds.clear();
+        if (extra.detector && !extra.markerIds.empty())
+          extra.detector->detectBoard(image, extra.charucoCorners, extra.charucoIds,
+            extra.markerCorners, extra.markerIds);
+      }
+    }
+
+    // ChArUco Board のコーナーの位置をサブピクセル精度で補正する
+    refineCorners(image, charucoCorners, subPixelWindow, subPixelCriteria);
+    for (auto& extra : extraBoards)
+      refineCorners(image, extra.charucoCorners, subPixelWindow, subPixelCriteria);
+
+    // 検出したマーカの大きさを次のフレームの検出に用いる
+    updateMarkerLengthRatio(markerCorners, image.size());
+  }
 
-  // コーナーが見つからなかったら何もしない
-  if (charucoCorners.empty()) return;
+  // ChArUco Board のコーナーが見つかればその位置を表示に描き込む
+  if (!charucoCorners.empty())
+    cv::aruco::drawDetectedCornersCharuco(image, charucoCorners, charucoIds, cv::Scalar(0, 0, 255));
 
-  // ChArUco Board のコーナーの位置を表示に描き込む
-  cv::aruco::drawDetectedCornersCharuco(image, charucoCorners, charucoIds, cv::Scalar(0, 0, 255));
+  // 追加の較正板の検出結果を表示に描き込む
+  for (const auto& extra : extraBoards)
+  {
+    if (!extra.charucoCorners.empty())
+      cv::aruco::drawDetectedCornersCharuco(image, extra.charucoCorners, extra.charucoIds, cv::Scalar(0, 255, 0));
+    else if (!extra.detector && !extra.markerIds.empty())
+      cv::aruco::drawDetectedMarkers(image, extra.markerCorners, extra.markerIds, cv::Scalar(0, 255, 0));
+  }
 }
 
 //
 // ArUco Marker を検出する
 //
-void Calibration::detectMarkers(cv::Mat& image, float markerLength)
+void Calibration::detectMarkers(cv::Mat& image, float markerLength,
+  unsigned long long sequence, unsigned int revision)
 {
-  // ArUco Marker のコーナーを検出する
-  detector->detectMarkers(image, corners, ids, rejected);
+  // 前回と同じ画像でなければ
+  if (!reuse(markerKey, sequence, revision))
+  {
+    // ArUco3 を使うなら前のフレームで求めたマーカの最小の大きさを検出器に設定する
+    if (detectorParams.useAruco3Detection) detector->setDetectorParameters(detectorParams);
+
+    // ArUco Marker のコーナーを検出する
+    detector->detectMarkers(image, corners, ids, rejected);
+
+    // 検出したマーカの大きさを次のフレームの検出に用いる
+    updateMarkerLengthRatio(corners, image.size());
+  }
 
   // コーナーが見つからなければ戻る
   if (corners.empty()) return;
@@ -181,6 +585,35 @@ void Calibration::recordCorners()
       totalCorners += static_cast<int>(charucoCorners.size());
     }
   }
+
+  // 追加の較正板はそれぞれ別の標本として記録する
+  for (const auto& extra : extraBoards)
+  {
+    // 較正板上の点と対応する画像上の点
+    std::vector<cv::Point3f> extraObjectPoints;
+    std::vector<cv::Point2f> extraImagePoints;
+
+    if (extra.detector)
+    {
+      // ChArUco Board ならコーナーが４つ以上見つかったときに対応を求める
+      if (extra.charucoCorners.size() < 4) continue;
+      extra.board->matchImagePoints(extra.charucoCorners, extra.charucoIds,
+        extraObjectPoints, extraImagePoints);
+    }
+    else
+    {
+      // GridBoard なら ArUco Marker が２つ以上見つかったときにそのコーナーとの対応を求める
+      if (extra.markerIds.size() < 2) continue;
+      extra.board->matchImagePoints(extra.markerCorners, extra.markerIds,
+        extraObjectPoints, extraImagePoints);
+    }
+
+    // 対応する点が見つかれば記録する
+    if (extraImagePoints.empty() || extraObjectPoints.empty()) continue;
+    allImagePoints.push_back(extraImagePoints);
+    allObjectPoints.push_back(extraObjectPoints);
+    totalCorners += static_cast<int>(extraImagePoints.size());
+  }
 #if defined(DEBUG)
   std::cerr << "charucoCorners = " << charucoCorners.size()
     << ", allCorners = " << allCorners.size() << "\n";
@@ -195,6 +628,8 @@ void Calibration::discardCorners()
   // 記録した標本を消去する
   allCorners.clear();
   allIds.clear();
+  allImagePoints.clear();
+  allObjectPoints.clear();
 
   // 較正結果を消去する
   cameraMatrix.release();
@@ -215,8 +650,8 @@ bool Calibration::calibrate()
   // 再投影誤差はとりあえず 0 にしておく
   repError = 0.0f;
 
-  // コーナーを合計６つ以上検出できていれば
-  if (allCorners.size() >= 6) try
+  // 標本を６つ以上記録できていれば
+  if (allImagePoints.size() >= 6) try
   {
     // CALIB_USE_INTRINSIC_GUESS が設定されていない場合に、
     // fx と fy をしてしたアスペクト比に強制する
@@ -327,7 +762,7 @@ void Calibration::getAllMarkerPoses(float markerLength, std::map<int, GgMatrix>&
 //
 // カメラパラメータの JSON オブジェクトから数値の配列を取得する
 //
-static bool getMatrix(const picojson::object& object,
+bool Calibration::getMatrix(const picojson::object& object,
   const std::string& key, cv::Mat& mat, int cols, int rows)
 {
   // key に一致するオブジェクトを探す
@@ -360,9 +795,9 @@ static bool getMatrix(const picojson::object& object,
 }
 
 //
-// カメラパラメータの JSON オブジェクトから数値の配列を取得する
+// カメラパラメータの JSON オブジェクトに数値の配列を格納する
 //
-static void setMatrix(picojson::object& object,
+void Calibration::setMatrix(picojson::object& object,
   const std::string& key, const cv::Mat& mat)
 {
   // picojson の配列
@@ -398,8 +833,14 @@ bool Calibration::loadParameters(const std::string& filename)
   json.close();
 
   // 構成内容の取り出し
-  const auto& object{ value.get<picojson::object>() };
+  return value.is<picojson::object>() && restoreParameters(value.get<picojson::object>());
+}
 
+//
+// JSON オブジェクトからキャリブレーションパラメータを取り出す
+//
+bool Calibration::restoreParameters(const picojson::object& object)
+{
   // オブジェクトが空だったらエラー
   if (object.empty()) return false;
 
@@ -431,14 +872,8 @@ bool Calibration::saveParameters(const std::string& filename) const
   // オブジェクト
   picojson::object object;
 
-  // カメラ行列
-  setMatrix(object, "camera matrix", cameraMatrix);
-
-  // 歪み定数
-  setMatrix(object, "distortion", distCoeffs);
-
-  // 再投影誤差
-  setValue(object, "error", repError);
+  // キャリブレーションパラメータを格納する
+  storeParameters(object);
 
   // 構成をシリアライズして保存
   picojson::value v{ object };
@@ -449,6 +884,21 @@ bool Calibration::saveParameters(const std::string& filename) const
   return true;
 }
 
+//
+// キャリブレーションパラメータを JSON オブジェクトに格納する
+//
+void Calibration::storeParameters(picojson::object& object) const
+{
+  // カメラ行列
+  setMatrix(object, "camera matrix", cameraMatrix);
+
+  // 歪み定数
+  setMatrix(object, "distortion", distCoeffs);
+
+  // 再投影誤差
+  setValue(object, "error", repError);
+}
+
 // ArUco Marker 辞書のリスト
 const std::map<const std::string, const cv::aruco::PredefinedDictionaryType> Calibration::dictionaryList
 {
@@ -18,6 +18,15 @@ using namespace gg;
 // ChArUco Board
 #include <opencv2/aruco/charuco.hpp>
 
+// 構成ファイルの読み取り補助
+#include "parseconfig.h"
+
+// ArUco Marker の検出の設定
+#include "DetectorSettings.h"
+
+// 追加の較正板の配置
+#include "BoardLayout.h"
+
 // 標準ライブラリ
 #include <map>
 
@@ -32,12 +41,63 @@ class Calibration
   /// ArUco Marker 検出器
   cv::Ptr<cv::aruco::ArucoDetector> detector;
 
+  /// ArUco Marker 検出器のパラメータ
+  cv::aruco::DetectorParameters detectorParams;
+
+  /// ChArUco Board のコーナーをサブピクセル精度で補正する窓の大きさの半分 (0 なら補正しない)
+  int subPixelWindow;
+
+  /// ChArUco Board のコーナーのサブピクセル精度の補正の終了条件
+  cv::TermCriteria subPixelCriteria;
+
   /// ChArUco Board
   cv::Ptr<cv::aruco::CharucoBoard> board;
 
+  /// ChArUco Board の横と縦のマス目の数
+  std::array<int, 2> squares;
+
   /// ChArUco Board 検出器
   cv::Ptr<cv::aruco::CharucoDetector> boardDetector;
 
+  ///
+  /// 同時に検出する追加の較正板
+  ///
+  struct ExtraBoard
+  {
+    /// 較正板の配置
+    BoardLayout layout;
+
+    /// 較正板
+    cv::Ptr<cv::aruco::Board> board;
+
+    /// ChArUco Board 検出器 (GridBoard なら空)
+    cv::Ptr<cv::aruco::CharucoDetector> detector;
+
+    /// この較正板の ArUco Marker の検出結果
+    std::vector<std::vector<cv::Point2f>> markerCorners;
+    std::vector<int> markerIds;
+
+    /// ChArUco Board のコーナーの検出結果
+    std::vector<cv::Point2f> charucoCorners;
+    std::vector<int> charucoIds;
+  };
+
+  /// 同時に検出する追加の較正板の配置
+  std::vector<BoardLayout> layouts;
+
+  /// 同時に検出する追加の較正板
+  std::vector<ExtraBoard> extraBoards;
+
+  ///
+  /// 追加の較正板を現在の辞書と検出器のパラメータで作成する
+  ///
+  /// @note
+  /// 辞書にない番号の ArUco Marker を使う較正板、長さが不正な較正板、
+  /// 選択している ChArUco Board や先の較正板と番号の範囲が重なる較正板は作成しない。
+  /// 最初の番号を指定していなければ直前の較正板が使う番号の次から使う。
+  ///
+  void createExtraBoards();
+
   /// ArUco Marker の検出結果
   std::vector<std::vector<cv::Point2f>> corners, rejected;
   std::vector<int> ids;
@@ -72,15 +132,63 @@ class Calibration
   /// 較正の設定
   int calibrationFlags;
 
+  /// 検出結果を得た画像の鍵 (フレームの転送番号, 展開に用いた設定の版, 検出器の版)
+  using DetectionKey = std::array<unsigned long long, 3>;
+
+  /// ArUco Marker の辞書と ChArUco Board の版 (作り直すたびに更新する)
+  unsigned int boardRevision;
+
+  /// ChArUco Board の検出結果を得た画像の鍵
+  DetectionKey boardKey;
+
+  /// ArUco Marker の検出結果を得た画像の鍵
+  DetectionKey markerKey;
+
+  ///
+  /// 前回の検出結果を再利用できるか調べて検出結果を得る画像の鍵を記録する
+  ///
+  /// @param key 前回の検出結果を得た画像の鍵
+  /// @param sequence 画像の元になったフレームの転送番号, 0 なら再利用しない
+  /// @param revision 画像を展開したときの設定の版
+  /// @return 前回と同じ画像を同じ検出器で検出するなら true
+  ///
+  bool reuse(DetectionKey& key, unsigned long long sequence, unsigned int revision) const;
+
+  ///
+  /// ArUco3 で次のフレームの検出に用いるマーカの最小の大きさを更新する
+  ///
+  /// @param markers 今回のフレームで検出した ArUco Marker のコーナー
+  /// @param imageSize 今回のフレームのサイズ
+  ///
+  /// @note
+  /// 検出したマーカの最も短い辺の長さを cameraMotionSpeed の分だけ小さくして、
+  /// 画像の長辺に対する比率を minMarkerLengthRatioOriginalImg に設定する。
+  /// マーカを検出できなかったときは 0 にして、次のフレームでは画像全体から探す。
+  ///
+  void updateMarkerLengthRatio(const std::vector<std::vector<cv::Point2f>>& markers,
+    const cv::Size& imageSize);
+
 public:
 
+  ///
+  /// 較正オブジェクトのデフォルトコンストラクタ
+  ///
+  /// @note
+  /// ChArUco Board は shareBoard() で別の較正オブジェクトと共有する。
+  ///
+  Calibration();
+
   ///
   /// 較正オブジェクトのコンストラクタ
   ///
   /// @param dictionaryName ArUco Marker の辞書名
   /// @param length ChArUco Board のマス目の一辺の長さと ArUco Marker の一辺の長さ (単位 cm)
+  /// @param squares ChArUco Board の横と縦のマス目の数
+  /// @param detectorSettings ArUco Marker の検出の設定
   ///
-  Calibration(const std::string& dictionaryName, const std::array<float, 2>& length);
+  Calibration(const std::string& dictionaryName, const std::array<float, 2>& length,
+    const std::array<int, 2>& squares = { 10, 7 },
+    const DetectorSettings& detectorSettings = DetectorSettings{});
 
   ///
   /// コピーコンストラクタは使用しない
@@ -108,6 +216,77 @@ public:
   ///
   void createBoard(const std::array<float, 2>& length);
 
+  ///
+  /// マス目の数を指定して ChArUco Board を作成する
+  ///
+  /// @param length ChArUco Board のマス目の一辺の長さと ArUco Marker の一辺の長さ (単位 cm)
+  /// @param newSquares ChArUco Board の横と縦のマス目の数
+  ///
+  void createBoard(const std::array<float, 2>& length, const std::array<int, 2>& newSquares)
+  {
+    squares = newSquares;
+    createBoard(length);
+  }
+
+  ///
+  /// ChArUco Board の横と縦のマス目の数を得る
+  ///
+  /// @return ChArUco Board の横と縦のマス目の数
+  ///
+  const auto& getBoardSquares() const
+  {
+    return squares;
+  }
+
+  ///
+  /// ArUco Marker の検出の設定を変更する
+  ///
+  /// @param detectorSettings ArUco Marker の検出の設定
+  ///
+  /// @note
+  /// ArUco Marker の検出器と ChArUco Board の検出器を作り直す。
+  ///
+  void setDetector(const DetectorSettings& detectorSettings);
+
+  ///
+  /// 同時に検出する追加の較正板を設定する
+  ///
+  /// @param newLayouts 追加の較正板の配置のリスト
+  /// @return 作成した追加の較正板の数
+  ///
+  /// @note
+  /// 追加の較正板があれば ArUco Marker の検出は一度だけ行い、
+  /// 検出したマーカを番号の範囲でそれぞれの較正板に振り分ける。
+  ///
+  size_t setBoards(const std::vector<BoardLayout>& newLayouts);
+
+  ///
+  /// 追加の較正板の数を得る
+  ///
+  /// @return 追加の較正板の数
+  ///
+  auto getExtraBoardCount() const
+  {
+    return extraBoards.size();
+  }
+
+  ///
+  /// 最後の検出で見つかった追加の較正板の数を得る
+  ///
+  /// @return マーカを一つ以上検出した追加の較正板の数
+  ///
+  int getDetectedExtraBoardCount() const;
+
+  ///
+  /// ArUco3 で検出に用いているマーカの最小の大きさを得る
+  ///
+  /// @return 画像の長辺に対するマーカの一辺の最小の長さの比率, 画像全体から探すときは 0
+  ///
+  auto getMarkerLengthRatio() const
+  {
+    return detectorParams.useAruco3Detection ? detectorParams.minMarkerLengthRatioOriginalImg : 0.0f;
+  }
+
   ///
   /// ArUco Marker の辞書と検出器を設定する
   ///
@@ -116,6 +295,13 @@ public:
   ///
   void setDictionary(const std::string& dictionaryName, const std::array<float, 2>& length);
 
+  ///
+  /// 別の較正オブジェクトと同じ ArUco Marker の辞書と ChArUco Board を使う
+  ///
+  /// @param calibration ArUco Marker の辞書と ChArUco Board を共有する較正オブジェクト
+  ///
+  void shareBoard(const Calibration& calibration);
+
   ///
   /// ChArUco Board を描く
   ///
@@ -129,16 +315,29 @@ public:
   /// ChArUco Board を検出する
   ///
   /// @param image ChArUco Board を検出する画像
+  /// @param sequence 画像の元になったフレームの転送番号, 0 なら検出結果を再利用しない
+  /// @param revision 画像を展開したときの設定の版
+  ///
+  /// @note
+  /// sequence と revision が前回と同じで ChArUco Board も作り直していなければ、
+  /// 前回の検出結果を再利用してコーナーの位置だけを描き込む。
   /// 
-  void detectBoard(cv::Mat& image);
+  void detectBoard(cv::Mat& image, unsigned long long sequence = 0, unsigned int revision = 0);
 
   ///
   /// ArUco Marker を検出する
   ///
   /// @param image ArUco Marker を検出する画像
   /// @param markerLength ArUco Marker の一辺の長さ (単位 cm)
+  /// @param sequence 画像の元になったフレームの転送番号, 0 なら検出結果を再利用しない
+  /// @param revision 画像を展開したときの設定の版
+  ///
+  /// @note
+  /// sequence と revision が前回と同じで ArUco Marker の辞書も変えていなければ、
+  /// 前回検出したコーナーを再利用して姿勢の推定と描き込みだけを行う。
   /// 
-  void detectMarkers(cv::Mat& image, float markerLength);
+  void detectMarkers(cv::Mat& image, float markerLength,
+    unsigned long long sequence = 0, unsigned int revision = 0);
 
   ///
   /// 標本を取得する
@@ -157,6 +356,46 @@ public:
   ///
   bool calibrate();
 
+  ///
+  /// ChArUco Board を取り出す
+  ///
+  /// @return ChArUco Board
+  ///
+  const auto& getBoard() const
+  {
+    return board;
+  }
+
+  ///
+  /// 最後に検出した ChArUco Board のコーナーの位置を取り出す
+  ///
+  /// @return ChArUco Board のコーナーの画像上の位置
+  ///
+  const auto& getCharucoCorners() const
+  {
+    return charucoCorners;
+  }
+
+  ///
+  /// 最後に検出した ChArUco Board のコーナーの番号を取り出す
+  ///
+  /// @return ChArUco Board のコーナーの番号
+  ///
+  const auto& getCharucoIds() const
+  {
+    return charucoIds;
+  }
+
+  ///
+  /// 最後に ChArUco Board を検出した画像のサイズを得る
+  ///
+  /// @return 入力画像のサイズ
+  ///
+  const auto& getImageSize() const
+  {
+    return size;
+  }
+
   ///
   /// 検出数を取得する
   ///
@@ -172,9 +411,12 @@ public:
   ///
   /// @return 保存された標本の数
   ///
+  /// @note
+  /// 追加の較正板の標本は較正板ごとに一つと数える。
+  ///
   auto getSampleCount() const
   {
-    return static_cast<int>(allCorners.size());
+    return static_cast<int>(allImagePoints.size());
   }
 
   ///
@@ -263,6 +505,44 @@ public:
   ///
   bool saveParameters(const std::string& filename) const;
 
+  ///
+  /// JSON オブジェクトからキャリブレーションパラメータを取り出す
+  ///
+  /// @param object キャリブレーションパラメータを格納した JSON オブジェクト
+  /// @return パラメータの取り出しに成功したら true
+  ///
+  bool restoreParameters(const picojson::object& object);
+
+  ///
+  /// キャリブレーションパラメータを JSON オブジェクトに格納する
+  ///
+  /// @param object キャリブレーションパラメータを格納する JSON オブジェクト
+  ///
+  void storeParameters(picojson::object& object) const;
+
+  ///
+  /// JSON オブジェクトから数値の配列を行列として取り出す
+  ///
+  /// @param object 数値の配列を格納した JSON オブジェクト
+  /// @param key 取り出す数値の配列のキー
+  /// @param mat 取り出した数値を格納する行列
+  /// @param cols 行列の列数
+  /// @param rows 行列の行数
+  /// @return 取り出しに成功したら true
+  ///
+  static bool getMatrix(const picojson::object& object,
+    const std::string& key, cv::Mat& mat, int cols, int rows);
+
+  ///
+  /// 行列を数値の配列として JSON オブジェクトに格納する
+  ///
+  /// @param object 数値の配列を格納する JSON オブジェクト
+  /// @param key 格納する数値の配列のキー
+  /// @param mat 格納する行列
+  ///
+  static void setMatrix(picojson::object& object,
+    const std::string& key, const cv::Mat& mat);
+
   /// ArUco Marker 辞書のリスト
   static const std::map<const std::string, const cv::aruco::PredefinedDictionaryType> dictionaryList;
 };
@@ -11,6 +11,9 @@
 // カメラ関連の処理
 #include "Camera.h"
 
+// 圧縮フレームの並列復号
+#include "Decoder.h"
+
 ///
 /// OpenCV を使ってビデオをキャプチャするクラス
 ///
@@ -25,6 +28,86 @@ class CamCv : public Camera
   /// 露出と利得
   int exposure, gain;
 
+  /// 色変換を行わずに取り出したフレームのデータ
+  cv::Mat packet;
+
+  /// 色変換を行わずに取り出すフレームのサイズ
+  std::array<int, 2> packetSize;
+
+  /// 圧縮フレームを並列に復号するなら復号器
+  std::unique_ptr<Decoder> decoder;
+
+  ///
+  /// フレームを取り出す
+  ///
+  /// @return フレームが取り出せたら true
+  ///
+  /// @note
+  /// YUV のフレームは OpenCV が返す生のデータを画素の格納形式に合わせた
+  /// 行列として参照する。生のデータが期待した大きさでなければ、
+  /// バックエンドが色変換を止められなかったものとして BGR で扱う。
+  ///
+  bool retrieveFrame()
+  {
+    // 圧縮フレームを並列に復号するとき
+    if (decoder)
+    {
+      // 圧縮フレームを取り出す
+      if (!camera.retrieve(packet)) return false;
+
+      // 圧縮フレームが１行のデータになっていなければ
+      if (packet.rows != 1)
+      {
+        // バックエンドが復号しているので以降は並列に復号しない
+        decoder.reset();
+        frame = packet;
+        return true;
+      }
+
+      // このフレームはこのスレッドで復号する
+      frame = cv::imdecode(packet, cv::IMREAD_COLOR);
+      return !frame.empty();
+    }
+
+    // 色変換を行っていればそのまま取り出す
+    if (format == FrameFormat::INTERLEAVED) return camera.retrieve(frame);
+
+    // 生のデータを取り出す
+    if (!camera.retrieve(packet)) return false;
+
+    // 生のデータが既に BGR の画像になっていたら
+    if (packet.rows == packetSize[1] && packet.cols == packetSize[0] && packet.channels() == 3)
+    {
+      // 以降は色変換されたフレームとして扱う
+      format = FrameFormat::INTERLEAVED;
+      frame = packet;
+      return true;
+    }
+
+    // 生のデータの長さ
+    const auto length{ packet.total() * packet.elemSize() };
+
+    // フレームの画素数
+    const auto count{ static_cast<size_t>(packetSize[0]) * packetSize[1] };
+
+    // YUYV なら横の画素数の２チャネルの行列として参照する
+    if (format == FrameFormat::YUYV && length >= count * 2)
+    {
+      frame = cv::Mat(packetSize[1], packetSize[0], CV_8UC2, packet.data);
+      return true;
+    }
+
+    // NV12 なら色差の平面を含めて縦の画素数の 1.5 倍の行数の１チャネルの行列として参照する
+    if (format == FrameFormat::NV12 && length >= count * 3 / 2)
+    {
+      frame = cv::Mat(packetSize[1] * 3 / 2, packetSize[0], CV_8UC1, packet.data);
+      return true;
+    }
+
+    // 取り出せなかった
+    return false;
+  }
+
   ///
   /// キャプチャデバイスを初期化する
   ///
@@ -32,9 +115,12 @@ class CamCv : public Camera
   /// @param initial_height キャプチャデバイスを開く際に期待するフレームの縦の画素数
   /// @param initial_fps キャプチャデバイスを開く際に期待するフレームフレームレート
   /// @param fourcc キャプチャデバイスを開く際に期待するコーデックの 4 文字
+  /// @param yuv YUV のフレームを色変換せずに取り出すなら true
+  /// @param parallel MJPEG のフレームを複数のスレッドで復号するなら true
   /// @return キャプチャデバイスが使用可能なら true
   ///
-  bool init(int initial_width, int initial_height, double initial_fps, const char* fourcc = "")
+  bool init(int initial_width, int initial_height, double initial_fps, const char* fourcc = "",
+    bool yuv = false, bool parallel = false)
   {
     // カメラのコーデック・解像度・フレームレートを設定する
     if (fourcc[0] != '\0') camera.set(cv::CAP_PROP_FOURCC,
@@ -47,6 +133,56 @@ class CamCv : public Camera
     const auto fps{ camera.get(cv::CAP_PROP_FPS) };
     if (fps > 0.0) interval = 1000.0 / fps;
 
+    // 画素の格納形式はとりあえず色変換後の形式にしておく
+    format = FrameFormat::INTERLEAVED;
+
+    // YUV のフレームを色変換せずに取り出すなら
+    if (yuv)
+    {
+      // 実際に使われるコーデックを調べて
+      const auto cc{ static_cast<int>(getCodec()) };
+
+      // YUV の形式なら画素の格納形式を記録する
+      if (cc == cv::VideoWriter::fourcc('Y', 'U', 'Y', 'V') || cc == cv::VideoWriter::fourcc('Y', 'U', 'Y', '2'))
+        format = FrameFormat::YUYV;
+      else if (cc == cv::VideoWriter::fourcc('N', 'V', '1', '2'))
+        format = FrameFormat::NV12;
+
+      // OpenCV による色変換を止められなかったら色変換後の形式にする
+      if (format != FrameFormat::INTERLEAVED && !camera.set(cv::CAP_PROP_CONVERT_RGB, 0))
+        format = FrameFormat::INTERLEAVED;
+
+      // 生のデータを解釈するためにフレームのサイズを記録しておく
+      packetSize[0] = static_cast<int>(camera.get(cv::CAP_PROP_FRAME_WIDTH));
+      packetSize[1] = static_cast<int>(camera.get(cv::CAP_PROP_FRAME_HEIGHT));
+    }
+
+    // 以前の復号器は使わない
+    decoder.reset();
+
+    // MJPEG のフレームを複数のスレッドで復号するときバックエンドの復号を止められたら
+    if (parallel && format == FrameFormat::INTERLEAVED
+      && static_cast<int>(getCodec()) == cv::VideoWriter::fourcc('M', 'J', 'P', 'G')
+      && camera.set(cv::CAP_PROP_CONVERT_RGB, 0))
+    {
+      // 復号したフレームを転送用の一時メモリに格納する復号器を用意する
+      decoder = std::make_unique<Decoder>([this](cv::Mat& image, unsigned long long skipped)
+      {
+        // ピクセルバッファオブジェクトをロックしてから
+        std::lock_guard lock{ mtx };
+
+        // 復号が追いつかずに捨てたフレームは転送しなかったフレームとして数える
+        dropped += skipped;
+
+        // 転送用の一時メモリにデータを格納したら
+        frame = image;
+        copyFrame();
+
+        // 新しいフレームがキャプチャされたことを通知する
+        setCaptured();
+      });
+    }
+
     // ムービーファイルのインポイント・アウトポイントの初期値とフレーム数
     in = camera.get(cv::CAP_PROP_POS_FRAMES);
     out = total = camera.get(cv::CAP_PROP_FRAME_COUNT);
@@ -62,7 +198,7 @@ class CamCv : public Camera
     exposure = static_cast<GLsizei>(camera.get(cv::CAP_PROP_EXPOSURE) * 10.0);
 
     // フレームを取り出してキャプチャ用のメモリを確保する
-    camera.retrieve(frame);
+    retrieveFrame();
 
 #if defined(DEBUG)
     char codec[5]{ 0, 0, 0, 0, 0 };
@@ -76,7 +212,7 @@ class CamCv : public Camera
     copyFrame();
 
     // フレームがキャプチャされたことを記録する
-    captured = true;
+    setCaptured();
 
     // カメラが使える
     return true;
@@ -96,8 +232,15 @@ class CamCv : public Camera
       // フレームを取り出せたら true
       auto status{ (total <= 0.0 || camera.get(cv::CAP_PROP_POS_FRAMES) < out) && camera.grab() };
 
+      // 圧縮フレームを並列に復号するなら
+      if (status && decoder)
+      {
+        // 圧縮フレームを取り出して復号を依頼する
+        if (camera.retrieve(packet)) decoder->submit(packet);
+      }
+
       // ムービーファイルでないかムービーファイルの終端でなければ次のフレームを取り出して
-      if (status && camera.retrieve(frame))
+      else if (status && retrieveFrame())
       {
         // ピクセルバッファオブジェクトをロックしてから
         std::lock_guard lock{ mtx };
@@ -106,7 +249,7 @@ class CamCv : public Camera
         copyFrame();
 
         // 新しいフレームがキャプチャされたことを通知する
-        captured = true;
+        setCaptured();
       }
 
       // 遅延時間
@@ -161,6 +304,7 @@ public:
     : elapsedTime{ 0.0 }
     , exposure{ 0 }
     , gain{ 0 }
+    , packetSize{ 0, 0 }
   {}
 
   ///
@@ -168,6 +312,11 @@ public:
   ///
   virtual ~CamCv()
   {
+    // 復号器より先にキャプチャスレッドを停止する
+    stop();
+
+    // 復号器を停止する
+    decoder.reset();
   }
 
   ///
@@ -178,12 +327,16 @@ public:
   /// @param height キャプチャデバイスを開く際に期待するフレームの縦の画素数, 0 ならお任せ
   /// @param fps キャプチャデバイスを開く際に期待するフレームフレームレート, 0 ならお任せ
   /// @param fourcc キャプチャデバイスを開く際に期待するコーデックの 4 文字, "" ならお任せ
+  /// @param pref キャプチャデバイスのバックエンド
+  /// @param yuv YUV のフレームを色変換せずに取り出すなら true
+  /// @param parallel MJPEG のフレームを複数のスレッドで復号するなら true
   /// @return キャプチャデバイスが使用可能なら true
   ///
-  auto open(int device, int width = 0, int height = 0, double fps = 0.0, const char* fourcc = "", int pref = cv::CAP_ANY)
+  auto open(int device, int width = 0, int height = 0, double fps = 0.0, const char* fourcc = "", int pref = cv::CAP_ANY,
+    bool yuv = false, bool parallel = false)
   {
     // カメラを開いて初期化する
-    return camera.open(device, pref) && init(width, height, fps, fourcc);
+    return camera.open(device, pref) && init(width, height, fps, fourcc, yuv, parallel);
   }
 
   ///
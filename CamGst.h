@@ -0,0 +1,430 @@
+﻿#pragma once
+
+///
+/// GStreamer の appsink を使ったビデオキャプチャクラスの定義
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 19, 2026
+///
+
+// カメラ関連の処理
+#include "Camera.h"
+
+#if defined(USE_GSTREAMER)
+// GStreamer
+#include <gst/gst.h>
+#include <gst/app/gstappsink.h>
+#include <gst/video/video.h>
+
+// 標準ライブラリ
+#include <chrono>
+
+///
+/// GStreamer の appsink からビデオをキャプチャするクラス
+///
+/// @description
+/// パイプラインの appsink にコールバック関数を設定し、ストリーミングスレッドから
+/// 受け取ったバッファを gst_buffer_map() でマップしたまま転送が終わるまで保持して、
+/// そこから直接ピクセルバッファオブジェクトに転送する。appsink は最新のフレームを
+/// 一つだけ保持して古いものを捨てる。YUY2 と NV12 は GPU で色変換する。
+/// キャプチャスレッドはパイプラインのバスを監視し、ファイルの終端で先頭に巻き戻す。
+///
+class CamGst : public Camera
+{
+  /// パイプライン
+  GstElement* pipeline;
+
+  /// フレームを受け取る appsink
+  GstAppSink* sink;
+
+  /// 転送するために保持しているサンプル, 保持していなければ nullptr
+  GstSample* held;
+
+  /// 保持しているサンプルのバッファをマップした情報
+  GstMapInfo mapping;
+
+  /// 詰め物を除いて詰め直したフレーム
+  cv::Mat packed;
+
+  /// 画素の形式の名前
+  std::array<char, 5> codec;
+
+  ///
+  /// パイプラインから appsink を探す
+  ///
+  /// @return 見つかった appsink の参照, なければ nullptr
+  ///
+  GstAppSink* findSink() const
+  {
+    // パイプラインが appsink だけならそれを使う
+    if (GST_IS_APP_SINK(pipeline)) return GST_APP_SINK(gst_object_ref(pipeline));
+    if (!GST_IS_BIN(pipeline)) return nullptr;
+
+    // パイプラインのシンクから最初の appsink を探す
+    GstAppSink* found{ nullptr };
+    const auto it{ gst_bin_iterate_sinks(GST_BIN(pipeline)) };
+    GValue item = G_VALUE_INIT;
+    while (!found && gst_iterator_next(it, &item) == GST_ITERATOR_OK)
+    {
+      const auto element{ g_value_get_object(&item) };
+      if (GST_IS_APP_SINK(element)) found = GST_APP_SINK(gst_object_ref(element));
+      g_value_reset(&item);
+    }
+    g_value_unset(&item);
+    gst_iterator_free(it);
+
+    return found;
+  }
+
+  ///
+  /// 保持しているサンプルを開放する
+  ///
+  /// @note
+  /// mtx をロックした状態で呼び出す。
+  ///
+  void release()
+  {
+    if (held)
+    {
+      gst_buffer_unmap(gst_sample_get_buffer(held), &mapping);
+      gst_sample_unref(held);
+      held = nullptr;
+    }
+  }
+
+  ///
+  /// appsink が新しいサンプルを受け取ったときに呼び出される
+  ///
+  /// @param appsink サンプルを受け取った appsink
+  /// @param data このオブジェクトのポインタ
+  /// @return ストリーミングを続けるなら GST_FLOW_OK
+  ///
+  /// @note
+  /// GStreamer のストリーミングスレッドから呼び出される。
+  ///
+  static GstFlowReturn newSample(GstAppSink* appsink, gpointer data)
+  {
+    // 受け取ったサンプルを取り出す
+    const auto sample{ gst_app_sink_pull_sample(appsink) };
+    if (!sample) return GST_FLOW_EOS;
+
+    // 取り出したサンプルを新しいフレームにする
+    static_cast<CamGst*>(data)->hold(sample);
+    return GST_FLOW_OK;
+  }
+
+  ///
+  /// 取り出したサンプルを新しいフレームにする
+  ///
+  /// @param sample 取り出したサンプル
+  ///
+  /// @note
+  /// 転送されずに残っていたサンプルは開放する。
+  ///
+  void hold(GstSample* sample)
+  {
+    // サンプルの画素の形式を調べて
+    GstVideoInfo info;
+    const auto buffer{ gst_sample_get_buffer(sample) };
+    if (!buffer || !gst_video_info_from_caps(&info, gst_sample_get_caps(sample)))
+    {
+      gst_sample_unref(sample);
+      return;
+    }
+    const auto videoFormat{ GST_VIDEO_INFO_FORMAT(&info) };
+    if (videoFormat != GST_VIDEO_FORMAT_YUY2 && videoFormat != GST_VIDEO_FORMAT_NV12
+      && videoFormat != GST_VIDEO_FORMAT_BGR)
+    {
+      gst_sample_unref(sample);
+      return;
+    }
+
+    // バッファをマップする
+    GstMapInfo newMapping;
+    if (!gst_buffer_map(buffer, &newMapping, GST_MAP_READ))
+    {
+      gst_sample_unref(sample);
+      return;
+    }
+
+    // ピクセルバッファオブジェクトをロックしてから
+    std::lock_guard lock{ mtx };
+
+    // 転送されずに残っていたサンプルを開放して取り出したサンプルを保持する
+    release();
+    held = sample;
+    mapping = newMapping;
+
+    // マップしたバッファをフレームとして参照する
+    const auto width{ GST_VIDEO_INFO_WIDTH(&info) };
+    const auto height{ GST_VIDEO_INFO_HEIGHT(&info) };
+    const auto data{ mapping.data + GST_VIDEO_INFO_PLANE_OFFSET(&info, 0) };
+    const auto stride{ static_cast<size_t>(GST_VIDEO_INFO_PLANE_STRIDE(&info, 0)) };
+    switch (videoFormat)
+    {
+    case GST_VIDEO_FORMAT_YUY2:
+      format = FrameFormat::YUYV;
+      frame = cv::Mat(height, width, CV_8UC2, data, stride);
+      break;
+    case GST_VIDEO_FORMAT_NV12:
+      format = FrameFormat::NV12;
+      {
+        // 色差の平面
+        const auto chroma{ mapping.data + GST_VIDEO_INFO_PLANE_OFFSET(&info, 1) };
+        const auto chromaStride{ static_cast<size_t>(GST_VIDEO_INFO_PLANE_STRIDE(&info, 1)) };
+
+        // 輝度と色差の平面が詰め物なしで続いていれば一つの行列として参照する
+        if (stride == static_cast<size_t>(width) && chromaStride == stride && chroma == data + stride * height)
+        {
+          frame = cv::Mat(height * 3 / 2, width, CV_8UC1, data);
+        }
+        else
+        {
+          // そうでなければ二つの平面を詰め直す
+          packed.create(height * 3 / 2, width, CV_8UC1);
+          cv::Mat(height, width, CV_8UC1, data, stride).copyTo(packed.rowRange(0, height));
+          cv::Mat(height / 2, width, CV_8UC1, chroma, chromaStride).copyTo(packed.rowRange(height, height * 3 / 2));
+          frame = packed;
+        }
+      }
+      break;
+    default:
+      format = FrameFormat::INTERLEAVED;
+      frame = cv::Mat(height, width, CV_8UC3, data, stride);
+      break;
+    }
+
+    // 行の終わりに詰め物があるとピクセルバッファオブジェクトにそのまま転送できないので詰め直す
+    if (!frame.isContinuous())
+    {
+      frame.copyTo(packed);
+      frame = packed;
+    }
+
+    // 画素の形式の名前とフレーム間隔を記録する
+    const auto name{ gst_video_format_to_string(videoFormat) };
+    for (int i = 0; i < 4; ++i) codec[i] = name[i] != '\0' ? name[i] : ' ';
+    if (GST_VIDEO_INFO_FPS_N(&info) > 0)
+      interval = 1000.0 * GST_VIDEO_INFO_FPS_D(&info) / GST_VIDEO_INFO_FPS_N(&info);
+
+    // 新しいフレームがキャプチャされたことを記録して
+    setCaptured();
+
+    // パイプラインの時計でバッファの表示時刻から遅れた分だけ取得した時刻を遡る
+    const auto pts{ GST_BUFFER_PTS(buffer) };
+    const auto segment{ gst_sample_get_segment(sample) };
+    if (GST_CLOCK_TIME_IS_VALID(pts) && segment)
+    {
+      if (const auto clock{ gst_element_get_clock(pipeline) })
+      {
+        const auto presented{ gst_segment_to_running_time(segment, GST_FORMAT_TIME, pts) };
+        const auto now{ gst_clock_get_time(clock) - gst_element_get_base_time(pipeline) };
+        gst_object_unref(clock);
+        if (GST_CLOCK_TIME_IS_VALID(presented) && now > presented)
+        {
+          const auto latency{ static_cast<double>(now - presented) * 1.0e-9 };
+          if (latency < 1.0) timestamp -= latency;
+        }
+      }
+    }
+  }
+
+  ///
+  /// 転送するフレームのデータを得る
+  ///
+  /// @return マップしたバッファの先頭のポインタと長さ
+  ///
+  std::pair<const GLubyte*, size_t> getPixels() const
+  {
+    return { frame.data, frame.total() * frame.elemSize() };
+  }
+
+  ///
+  /// パイプラインのバスを監視する
+  ///
+  /// @note
+  /// フレームはストリーミングスレッドから受け取るので、
+  /// キャプチャスレッドではファイルの終端の巻き戻しだけを行う。
+  ///
+  void capture()
+  {
+    // パイプラインのバス
+    const auto bus{ gst_element_get_bus(pipeline) };
+    if (!bus) return;
+
+    // スレッドが実行可の間
+    while (running)
+    {
+      // 終端かエラーのメッセージを待って
+      const auto message{ gst_bus_timed_pop_filtered(bus, 100 * GST_MSECOND,
+        static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR)) };
+      if (!message) continue;
+
+      // 終端に到達していたら先頭に巻き戻す
+      if (GST_MESSAGE_TYPE(message) == GST_MESSAGE_EOS)
+      {
+        gst_element_seek_simple(pipeline, GST_FORMAT_TIME,
+          static_cast<GstSeekFlags>(GST_SEEK_FLAG_FLUSH | GST_SEEK_FLAG_KEY_UNIT), 0);
+      }
+#if defined(DEBUG)
+      else
+      {
+        GError* error{ nullptr };
+        gst_message_parse_error(message, &error, nullptr);
+        std::cerr << "GStreamer: " << error->message << "\n";
+        g_error_free(error);
+      }
+#endif
+
+      gst_message_unref(message);
+    }
+
+    gst_object_unref(bus);
+  }
+
+public:
+
+  ///
+  /// コンストラクタ
+  ///
+  CamGst()
+    : pipeline{ nullptr }
+    , sink{ nullptr }
+    , held{ nullptr }
+    , mapping{}
+    , codec{ "    " }
+  {
+  }
+
+  ///
+  /// デストラクタ
+  ///
+  virtual ~CamGst()
+  {
+    // キャプチャスレッドを停止してからパイプラインを閉じる
+    stop();
+    close();
+  }
+
+  ///
+  /// パイプラインを開く
+  ///
+  /// @param description 開くパイプラインの記述, appsink を含む
+  /// @param yuv YUV のフレームを色変換せずに取り出すなら true
+  /// @return パイプラインが使用可能なら true
+  ///
+  /// @note
+  /// appsink に受け取る形式を YUV なら YUY2 と NV12 と BGR, そうでなければ BGR に制限する。
+  /// パイプラインの appsink の前に videoconvert がなければ、
+  /// ソースがこれらの形式を出力できないと開けない。
+  ///
+  bool open(const std::string& description, bool yuv = false)
+  {
+    // 開いていたパイプラインを閉じる
+    close();
+
+    // GStreamer を初期化する
+    if (!gst_is_initialized()) gst_init(nullptr, nullptr);
+
+    // パイプラインを作成する
+    GError* error{ nullptr };
+    pipeline = gst_parse_launch(description.c_str(), &error);
+    if (error)
+    {
+#if defined(DEBUG)
+      std::cerr << "GStreamer: " << error->message << "\n";
+#endif
+      g_error_free(error);
+    }
+    if (!pipeline) return false;
+
+    // パイプラインの appsink を探す
+    sink = findSink();
+    if (!sink)
+    {
+      close();
+      return false;
+    }
+
+    // appsink が受け取る形式を制限する
+    const auto caps{ gst_caps_from_string(yuv
+      ? "video/x-raw, format=(string){ YUY2, NV12, BGR }"
+      : "video/x-raw, format=(string)BGR") };
+    gst_app_sink_set_caps(sink, caps);
+    gst_caps_unref(caps);
+
+    // 最新のフレームだけを保持して古いフレームは捨てる
+    gst_app_sink_set_max_buffers(sink, 1);
+    gst_app_sink_set_drop(sink, TRUE);
+
+    // 新しいサンプルを受け取ったときに呼び出す関数を設定する
+    GstAppSinkCallbacks callbacks{};
+    callbacks.new_sample = newSample;
+    gst_app_sink_set_callbacks(sink, &callbacks, this, nullptr);
+
+    // パイプラインを再生する
+    if (gst_element_set_state(pipeline, GST_STATE_PLAYING) == GST_STATE_CHANGE_FAILURE)
+    {
+      close();
+      return false;
+    }
+
+    // 最初のフレームが取得できるまで待つ
+    for (int i = 0; i < 200; ++i)
+    {
+      {
+        std::lock_guard lock{ mtx };
+        if (held) return true;
+      }
+      std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+
+    // 最初のフレームが取得できなかったらパイプラインは使えない
+    close();
+    return false;
+  }
+
+  ///
+  /// パイプラインを閉じる
+  ///
+  void close()
+  {
+    // バスを監視しているキャプチャスレッドを停止する
+    stop();
+
+    // パイプラインが開かれていたら
+    if (pipeline)
+    {
+      // パイプラインを停止してストリーミングスレッドからの呼び出しを止めて
+      gst_element_set_state(pipeline, GST_STATE_NULL);
+
+      // appsink とパイプラインを開放する
+      if (sink) gst_object_unref(sink);
+      gst_object_unref(pipeline);
+      sink = nullptr;
+      pipeline = nullptr;
+    }
+
+    // 保持しているサンプルを開放する
+    {
+      std::lock_guard lock{ mtx };
+      release();
+      frame = cv::Mat{};
+    }
+
+    // キャプチャデバイスを閉じる
+    Camera::close();
+  }
+
+  ///
+  /// 画素の形式を調べる
+  ///
+  /// @param fourcc 画素の形式の名前の 4 文字の格納先
+  ///
+  void getCodec(char* fourcc) const
+  {
+    for (int i = 0; i < 4; ++i) fourcc[i] = codec[i];
+  }
+};
+#endif
@@ -61,7 +61,7 @@ public:
     copyFrame();
 
     // 画像が読み込まれたことを記録する
-    captured = true;
+    setCaptured();
 
     // 画像ファイルが開けた
     return true;
@@ -0,0 +1,413 @@
+﻿#pragma once
+
+///
+/// Video for Linux を直接使ったビデオキャプチャクラスの定義
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 19, 2026
+///
+
+// カメラ関連の処理
+#include "Camera.h"
+
+#if defined(__linux__)
+// Video for Linux
+#include <cerrno>
+#include <cstring>
+#include <ctime>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/select.h>
+#include <unistd.h>
+#include <linux/videodev2.h>
+
+///
+/// Video for Linux を直接使ってビデオをキャプチャするクラス
+///
+/// @description
+/// VIDIOC_REQBUFS で確保したメモリマップのバッファにキャプチャし、
+/// 取り出したバッファを転送が終わるまで保持してそこから直接
+/// ピクセルバッファオブジェクトに転送する。色変換はしないので
+/// YUYV と NV12 は GPU で色変換する。
+///
+class CamV4l2 : public Camera
+{
+  /// キャプチャデバイスのファイル記述子
+  int fd;
+
+  ///
+  /// メモリマップしたバッファ
+  ///
+  struct Mapping
+  {
+    /// バッファの先頭
+    void* start;
+
+    /// バッファの長さ
+    size_t length;
+  };
+
+  /// メモリマップしたバッファ
+  std::vector<Mapping> buffers;
+
+  /// 転送するために保持しているバッファの番号, 保持していなければ -1
+  int held;
+
+  /// 確保するバッファの数
+  static constexpr unsigned int bufferCount{ 4 };
+
+  /// フレームの横と縦の画素数とフレームの一行のバイト数
+  std::array<int, 2> size;
+
+  /// フレームの一行のバイト数
+  int stride;
+
+  /// 画素の形式
+  __u32 pixelFormat;
+
+  ///
+  /// シグナルで中断されても ioctl を繰り返す
+  ///
+  int xioctl(unsigned long request, void* arg) const
+  {
+    int status;
+    do status = ioctl(fd, request, arg); while (status < 0 && errno == EINTR);
+    return status;
+  }
+
+  ///
+  /// フレームが取得できるまで待ってバッファを取り出す
+  ///
+  /// @param timeout 待つ時間 (ミリ秒)
+  /// @param buffer 取り出したバッファの情報の格納先
+  /// @return バッファが取り出せたら true
+  ///
+  bool dequeue(int timeout, v4l2_buffer& buffer) const
+  {
+    // フレームが取得できるまで待つ
+    fd_set fds;
+    FD_ZERO(&fds);
+    FD_SET(fd, &fds);
+    timeval tv{ timeout / 1000, (timeout % 1000) * 1000 };
+    if (select(fd + 1, &fds, nullptr, nullptr, &tv) <= 0) return false;
+
+    // バッファを取り出す
+    buffer = v4l2_buffer{};
+    buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buffer.memory = V4L2_MEMORY_MMAP;
+    return xioctl(VIDIOC_DQBUF, &buffer) == 0 && buffer.index < buffers.size();
+  }
+
+  ///
+  /// 取り出したバッファを新しいフレームにする
+  ///
+  /// @param buffer 取り出したバッファの情報
+  ///
+  /// @note
+  /// mtx をロックした状態で呼び出す。
+  /// 転送されずに残っていたバッファはキャプチャデバイスに戻す。
+  ///
+  void hold(const v4l2_buffer& buffer)
+  {
+    // 保持していたバッファをキャプチャデバイスに戻す
+    if (held >= 0) enqueue(held);
+    held = static_cast<int>(buffer.index);
+
+    // 取り出したバッファをフレームとして参照する
+    auto data{ static_cast<GLubyte*>(buffers[held].start) };
+    frame = format == FrameFormat::NV12
+      ? cv::Mat(size[1] * 3 / 2, size[0], CV_8UC1, data, stride)
+      : format == FrameFormat::YUYV
+      ? cv::Mat(size[1], size[0], CV_8UC2, data, stride)
+      : cv::Mat(size[1], size[0], CV_8UC3, data, stride);
+
+    // 新しいフレームがキャプチャされたことを記録して
+    setCaptured();
+
+    // カーネルが記録した取得時刻の分だけ取得した時刻を遡る
+    timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    if (buffer.flags & V4L2_BUF_FLAG_TIMESTAMP_MONOTONIC)
+    {
+      const auto latency{ (now.tv_sec - buffer.timestamp.tv_sec)
+        + (now.tv_nsec / 1000 - buffer.timestamp.tv_usec) * 1.0e-6 };
+      if (latency > 0.0 && latency < 1.0) timestamp -= latency;
+    }
+  }
+
+  ///
+  /// バッファをキャプチャデバイスに戻す
+  ///
+  /// @param index バッファの番号
+  ///
+  void enqueue(int index) const
+  {
+    v4l2_buffer buffer{};
+    buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    buffer.memory = V4L2_MEMORY_MMAP;
+    buffer.index = index;
+    xioctl(VIDIOC_QBUF, &buffer);
+  }
+
+  ///
+  /// 転送するフレームのデータを得る
+  ///
+  /// @return 保持しているバッファの先頭のポインタと長さ
+  ///
+  std::pair<const GLubyte*, size_t> getPixels() const
+  {
+    return { frame.data, frame.total() * frame.elemSize() };
+  }
+
+  ///
+  /// フレームをキャプチャする
+  ///
+  void capture()
+  {
+    // スレッドが実行可の間
+    while (running)
+    {
+      // フレームが取得できたら
+      v4l2_buffer buffer;
+      if (dequeue(100, buffer))
+      {
+        // ピクセルバッファオブジェクトをロックしてから
+        std::lock_guard lock{ mtx };
+
+        // 取り出したバッファを新しいフレームにする
+        hold(buffer);
+      }
+    }
+  }
+
+public:
+
+  ///
+  /// コンストラクタ
+  ///
+  CamV4l2()
+    : fd{ -1 }
+    , held{ -1 }
+    , size{ 0, 0 }
+    , stride{ 0 }
+    , pixelFormat{ 0 }
+  {}
+
+  ///
+  /// デストラクタ
+  ///
+  virtual ~CamV4l2()
+  {
+    // キャプチャスレッドを停止してからキャプチャデバイスを閉じる
+    stop();
+    close();
+  }
+
+  ///
+  /// キャプチャデバイスを開く
+  ///
+  /// @param device キャプチャデバイスの番号 (/dev/videoN の N)
+  /// @param width キャプチャデバイスを開く際に期待するフレームの横の画素数, 0 ならお任せ
+  /// @param height キャプチャデバイスを開く際に期待するフレームの縦の画素数, 0 ならお任せ
+  /// @param fps キャプチャデバイスを開く際に期待するフレームフレームレート, 0 ならお任せ
+  /// @param fourcc キャプチャデバイスを開く際に期待する画素の形式の 4 文字, "" なら YUYV
+  /// @return キャプチャデバイスが使用可能なら true
+  ///
+  /// @note
+  /// 無変換で転送できる YUYV, NV12, BGR3 以外の形式になったら使用できない。
+  ///
+  bool open(int device, int width = 0, int height = 0, double fps = 0.0, const char* fourcc = "")
+  {
+    // 既に開いていたら閉じる
+    close();
+
+    // デバイスファイルを開く
+    const auto path{ "/dev/video" + std::to_string(device) };
+    fd = ::open(path.c_str(), O_RDWR | O_NONBLOCK);
+    if (fd < 0) return false;
+
+    // ストリーミングで映像を入力できるキャプチャデバイスでなければ使えない
+    v4l2_capability capability{};
+    const auto caps{ xioctl(VIDIOC_QUERYCAP, &capability) == 0
+      ? (capability.capabilities & V4L2_CAP_DEVICE_CAPS) ? capability.device_caps : capability.capabilities
+      : 0u };
+    if (!(caps & V4L2_CAP_VIDEO_CAPTURE) || !(caps & V4L2_CAP_STREAMING))
+    {
+      close();
+      return false;
+    }
+
+    // 画素の形式と解像度を設定する
+    v4l2_format fmt{};
+    fmt.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (xioctl(VIDIOC_G_FMT, &fmt) < 0)
+    {
+      close();
+      return false;
+    }
+    if (width > 0) fmt.fmt.pix.width = width;
+    if (height > 0) fmt.fmt.pix.height = height;
+    fmt.fmt.pix.pixelformat = fourcc[0] != '\0'
+      ? v4l2_fourcc(fourcc[0], fourcc[1], fourcc[2], fourcc[3]) : V4L2_PIX_FMT_YUYV;
+    fmt.fmt.pix.field = V4L2_FIELD_ANY;
+    if (xioctl(VIDIOC_S_FMT, &fmt) < 0)
+    {
+      close();
+      return false;
+    }
+
+    // 実際に設定された画素の形式が無変換で転送できなければ使えない
+    pixelFormat = fmt.fmt.pix.pixelformat;
+    size = { static_cast<int>(fmt.fmt.pix.width), static_cast<int>(fmt.fmt.pix.height) };
+    stride = static_cast<int>(fmt.fmt.pix.bytesperline);
+    int bytes;
+    switch (pixelFormat)
+    {
+    case V4L2_PIX_FMT_YUYV:
+      format = FrameFormat::YUYV;
+      bytes = 2;
+      break;
+    case V4L2_PIX_FMT_NV12:
+      format = FrameFormat::NV12;
+      bytes = 1;
+      break;
+    case V4L2_PIX_FMT_BGR24:
+      format = FrameFormat::INTERLEAVED;
+      bytes = 3;
+      break;
+    default:
+      close();
+      return false;
+    }
+
+    // 行の終わりに詰め物があるとピクセルバッファオブジェクトにそのまま転送できない
+    if (stride != size[0] * bytes)
+    {
+      close();
+      return false;
+    }
+
+    // フレームレートを設定する
+    v4l2_streamparm parm{};
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (fps > 0.0 && xioctl(VIDIOC_G_PARM, &parm) == 0
+      && (parm.parm.capture.capability & V4L2_CAP_TIMEPERFRAME))
+    {
+      parm.parm.capture.timeperframe = { 1000, static_cast<__u32>(fps * 1000.0 + 0.5) };
+      xioctl(VIDIOC_S_PARM, &parm);
+    }
+
+    // 実際のフレームレートからフレーム間隔を求める
+    parm = v4l2_streamparm{};
+    parm.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    if (xioctl(VIDIOC_G_PARM, &parm) == 0 && parm.parm.capture.timeperframe.denominator > 0)
+      interval = 1000.0 * parm.parm.capture.timeperframe.numerator / parm.parm.capture.timeperframe.denominator;
+
+    // メモリマップのバッファを確保する
+    v4l2_requestbuffers request{};
+    request.count = bufferCount;
+    request.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    request.memory = V4L2_MEMORY_MMAP;
+    if (xioctl(VIDIOC_REQBUFS, &request) < 0 || request.count < 2)
+    {
+      close();
+      return false;
+    }
+
+    // 確保したバッファをメモリマップしてキャプチャデバイスに渡す
+    for (unsigned int i = 0; i < request.count; ++i)
+    {
+      v4l2_buffer buffer{};
+      buffer.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+      buffer.memory = V4L2_MEMORY_MMAP;
+      buffer.index = i;
+      if (xioctl(VIDIOC_QUERYBUF, &buffer) < 0)
+      {
+        close();
+        return false;
+      }
+      const auto start{ mmap(nullptr, buffer.length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, buffer.m.offset) };
+      if (start == MAP_FAILED)
+      {
+        close();
+        return false;
+      }
+      buffers.push_back({ start, buffer.length });
+      enqueue(i);
+    }
+
+    // キャプチャを開始する
+    v4l2_buf_type type{ V4L2_BUF_TYPE_VIDEO_CAPTURE };
+    if (xioctl(VIDIOC_STREAMON, &type) < 0)
+    {
+      close();
+      return false;
+    }
+
+    // 最初のフレームが取得できなかったらカメラは使えない
+    v4l2_buffer buffer;
+    if (!dequeue(2000, buffer))
+    {
+      close();
+      return false;
+    }
+
+    // 最初のフレームを保持する
+    std::lock_guard lock{ mtx };
+    hold(buffer);
+
+    // カメラが使える
+    return true;
+  }
+
+  ///
+  /// キャプチャデバイスを閉じる
+  ///
+  void close()
+  {
+    // バッファを参照しているキャプチャスレッドを停止する
+    stop();
+
+    // キャプチャデバイスが開かれていたら
+    if (fd >= 0)
+    {
+      // キャプチャを停止して
+      v4l2_buf_type type{ V4L2_BUF_TYPE_VIDEO_CAPTURE };
+      xioctl(VIDIOC_STREAMOFF, &type);
+
+      // メモリマップを解除して
+      for (const auto& buffer : buffers) munmap(buffer.start, buffer.length);
+      buffers.clear();
+
+      // バッファを開放して
+      v4l2_requestbuffers request{};
+      request.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+      request.memory = V4L2_MEMORY_MMAP;
+      xioctl(VIDIOC_REQBUFS, &request);
+
+      // デバイスファイルを閉じる
+      ::close(fd);
+      fd = -1;
+    }
+
+    // 保持しているバッファはない
+    held = -1;
+    frame = cv::Mat{};
+
+    // キャプチャデバイスを閉じる
+    Camera::close();
+  }
+
+  ///
+  /// 画素の形式を調べる
+  ///
+  /// @param forcc 使用している画素の形式を表す 4 文字の格納先
+  ///
+  void getCodec(char* fourcc) const
+  {
+    for (int i = 0; i < 4; ++i) fourcc[i] = static_cast<char>((pixelFormat >> (i * 8)) & 0x7f);
+  }
+};
+#endif
@@ -11,6 +11,9 @@
 // 補助プログラム
 #include "gg.h"
 
+// フレームの画素の格納形式
+#include "Buffer.h"
+
 // OpenCV
 #include <opencv2/opencv.hpp>
 #if defined(_MSC_VER)
@@ -32,6 +35,7 @@
 // 非同期処理
 #include <thread>
 #include <mutex>
+#include <atomic>
 
 ///
 /// キャプチャデバイス関連の基底クラス
@@ -49,12 +53,36 @@ protected:
   /// OpenCV のキャプチャデバイスから取得したフレーム
   cv::Mat frame;
 
+  /// 取得したフレームの画素の格納形式
+  FrameFormat format;
+
   /// キャプチャフレームを GPU に送るために用いる一時メモリ
   std::vector<GLubyte> pixels;
 
   /// 新しいフレームが取得されたら true
   bool captured;
 
+  /// 最後にフレームを取得した時刻
+  double timestamp;
+
+  /// 取得したフレームの通し番号 (キャプチャスレッドで更新してメインスレッドで参照する)
+  std::atomic<unsigned long long> sequence;
+
+  /// 最後に転送したフレームの転送番号
+  unsigned long long transmitted;
+
+  /// 最後に転送したフレームの通し番号
+  unsigned long long transmittedFrame;
+
+  /// 最後に転送したフレームを取得した時刻
+  double transmittedTime;
+
+  /// 転送せずに次のフレームで置き換えたか捨てたフレームの数 (キャプチャスレッドでも更新する)
+  std::atomic<unsigned long long> dropped;
+
+  /// すべてのキャプチャデバイスで転送したフレームの数
+  static inline std::atomic<unsigned long long> transmissions{ 0 };
+
   /// キャプチャを非同期に行うためのスレッド
   std::thread thr;
 
@@ -81,6 +109,63 @@ protected:
     std::copy(frame.data, frame.data + length, pixels.data());
   }
 
+  ///
+  /// 新しいフレームが取得されたことを記録する
+  ///
+  /// @note
+  /// mtx をロックした状態で呼び出す。
+  ///
+  void setCaptured()
+  {
+    // 取得した時刻と通し番号を記録する
+    timestamp = glfwGetTime();
+    ++sequence;
+
+    // 新しいフレームがキャプチャされたことを通知する
+    captured = true;
+
+    // イベントを待っているメインループを起こす
+    glfwPostEmptyEvent();
+  }
+
+  ///
+  /// フレームを転送したことを記録する
+  ///
+  /// @note
+  /// mtx をロックした状態で呼び出す。前回転送したフレームとの間に
+  /// 取得したフレームは転送しなかったものとして数える。
+  /// 転送先によらず転送番号を同じように更新する。
+  ///
+  void setTransmitted()
+  {
+    // すべてのキャプチャデバイスを通して一意な転送番号を記録する
+    transmitted = ++transmissions;
+
+    // 前回転送したフレームとの通し番号の差から転送しなかったフレームを数える
+    if (transmittedFrame > 0 && sequence > transmittedFrame) dropped += sequence - transmittedFrame - 1;
+
+    // 転送したフレームの通し番号と取得した時刻を記録する
+    transmittedFrame = sequence;
+    transmittedTime = timestamp;
+
+    // 次のフレームの取得を待つ
+    captured = false;
+  }
+
+  ///
+  /// 転送するフレームのデータを得る
+  ///
+  /// @return 転送するフレームのデータの先頭のポインタと長さ
+  ///
+  /// @note
+  /// mtx をロックした状態で呼び出す。キャプチャデバイスのメモリを
+  /// 直接参照するクラスは一時メモリの代わりにそのメモリを返す。
+  ///
+  virtual std::pair<const GLubyte*, size_t> getPixels() const
+  {
+    return { pixels.data(), pixels.size() };
+  }
+
   ///
   /// フレームをキャプチャする
   ///
@@ -104,7 +189,14 @@ public:
   Camera()
     : total{ -1.0 }
     , interval{ 10.0 }
+    , format{ FrameFormat::INTERLEAVED }
     , captured{ false }
+    , timestamp{ 0.0 }
+    , sequence{ 0 }
+    , transmitted{ 0 }
+    , transmittedFrame{ 0 }
+    , transmittedTime{ -1.0 }
+    , dropped{ 0 }
     , running{ false }
     , in{ -1.0 }
     , out{ -1.0 }
@@ -172,47 +264,133 @@ public:
   /// キャプチャデバイスをロックしてフレームをピクセルバッファオブジェクトに転送する
   ///
   /// @param buffer 転送先のピクセルバッファオブジェクト
+  /// @return 新しいフレームを転送したら true
   ///
-  void transmit(GLuint buffer)
+  bool transmit(GLuint buffer)
   {
     // 新しいフレームが取得されているときカメラのロックが成功したら
     if (captured && mtx.try_lock())
     {
       // フレームをピクセルバッファオブジェクトに転送して
+      const auto [data, length] { getPixels() };
       glBindBuffer(GL_PIXEL_PACK_BUFFER, buffer);
-      glBufferSubData(GL_PIXEL_PACK_BUFFER, 0, pixels.size(), pixels.data());
+      glBufferSubData(GL_PIXEL_PACK_BUFFER, 0, length, data);
       glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
 
-       // 次のフレームの取得を待つ
-      captured = false;
+      // 転送したことを記録して次のフレームの取得を待つ
+      setTransmitted();
 
       // キャプチャデバイスのロックを解除する
       mtx.unlock();
+      return true;
     }
+
+    // 新しいフレームは転送していない
+    return false;
   }
 
   ///
   /// キャプチャデバイスをロックしてフレームをメモリに転送する
   ///
   /// @param buffer 転送先のメモリ
+  /// @return 新しいフレームを転送したら true
   ///
-  void transmit(cv::Mat& buffer)
+  bool transmit(cv::Mat& buffer)
   {
     // 新しいフレームが取得されているときカメラのロックが成功したら
     if (captured && mtx.try_lock())
     {
       // フレームを cv::Mat にして
-      cv::Mat image{ frame.size(), CV_8UC(frame.channels()), pixels.data() };
-
-      // 呼び出し元にコピーしたら
-      buffer = image.clone();
-
-      // 次のフレームの取得を待つ
-      captured = false;
+      cv::Mat image{ frame.size(), CV_8UC(frame.channels()), const_cast<GLubyte*>(getPixels().first) };
+
+      // 画素の格納形式に合わせて BGR に変換して呼び出し元にコピーしたら
+      switch (format)
+      {
+      case FrameFormat::YUYV:
+        cv::cvtColor(image, buffer, cv::COLOR_YUV2BGR_YUYV);
+        break;
+      case FrameFormat::NV12:
+        cv::cvtColor(image, buffer, cv::COLOR_YUV2BGR_NV12);
+        break;
+      default:
+        buffer = image.clone();
+        break;
+      }
+
+      // 転送したことを記録して次のフレームの取得を待つ
+      setTransmitted();
 
       // キャプチャデバイスのロックを解除する
       mtx.unlock();
+      return true;
     }
+
+    // 新しいフレームは転送していない
+    return false;
+  }
+
+  ///
+  /// まだ転送していないフレームを取得した時刻を調べる
+  ///
+  /// @return 新しいフレームが取得されていればその時刻, なければ負の値
+  ///
+  double getCapturedTime()
+  {
+    std::lock_guard lock{ mtx };
+    return captured ? timestamp : -1.0;
+  }
+
+  ///
+  /// まだ転送していないフレームを捨てる
+  ///
+  void skip()
+  {
+    std::lock_guard lock{ mtx };
+    captured = false;
+  }
+
+  ///
+  /// 取得したフレームの通し番号を得る
+  ///
+  /// @return 取得したフレームの通し番号
+  ///
+  auto getSequence() const
+  {
+    return sequence.load();
+  }
+
+  ///
+  /// 最後にピクセルバッファオブジェクトに転送したフレームの転送番号を得る
+  ///
+  /// @return 最後に転送したフレームの転送番号, まだ転送していなければ 0
+  ///
+  /// @note
+  /// 転送番号はすべてのキャプチャデバイスを通して一意なので、
+  /// キャプチャデバイスを開き直しても同じフレームとみなすことはない。
+  ///
+  auto getTransmittedSequence() const
+  {
+    return transmitted;
+  }
+
+  ///
+  /// 最後に転送したフレームを取得した時刻を得る
+  ///
+  /// @return 最後に転送したフレームを取得した時刻 (glfwGetTime() の時刻), まだ転送していなければ負の値
+  ///
+  auto getTransmittedTime() const
+  {
+    return transmittedTime;
+  }
+
+  ///
+  /// 転送しなかったフレームの数を得る
+  ///
+  /// @return 転送する前に次のフレームで置き換えたか捨てたフレームの数
+  ///
+  auto getDroppedFrames() const
+  {
+    return dropped.load();
   }
 
   ///
@@ -241,7 +419,7 @@ public:
   ///
   std::array<int, 2> getSize() const
   {
-    return std::array<int, 2>{ frame.cols, frame.rows };
+    return std::array<int, 2>{ getWidth(), getHeight() };
   }
 
   ///
@@ -259,9 +437,12 @@ public:
   ///
   /// @return キャプチャ中のフレームの縦の画素数
   ///
-  auto getHeight() const
+  /// @note
+  /// NV12 のフレームは色差の平面の分だけ行数が 1.5 倍になっている。
+  ///
+  int getHeight() const
   {
-    return frame.rows;
+    return format == FrameFormat::NV12 ? frame.rows * 2 / 3 : frame.rows;
   }
 
   ///
@@ -274,6 +455,16 @@ public:
     return frame.channels();
   }
 
+  ///
+  /// キャプチャしたフレームの画素の格納形式を調べる
+  ///
+  /// @return キャプチャしたフレームの画素の格納形式
+  ///
+  auto getFrameFormat() const
+  {
+    return format;
+  }
+
   ///
   /// ムービーファイルの総フレーム数を得る
   ///
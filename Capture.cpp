@@ -7,6 +7,30 @@
 ///
 #include "Capture.h"
 
+// 標準ライブラリ
+#include <limits>
+
+//
+// 選択しているキャプチャデバイスを置き換える
+//
+void Capture::replace(std::unique_ptr<Camera>&& newCamera)
+{
+  // 追加したキャプチャデバイスは置き換える前のキャプチャデバイスと組にしていたので閉じる
+  closeExtras();
+
+  // 新しいキャプチャデバイスを使うことにする
+  camera = std::move(newCamera);
+}
+
+//
+// 追加したキャプチャデバイスを閉じる
+//
+void Capture::closeExtras()
+{
+  for (auto& extra : extras) extra->close();
+  extras.clear();
+}
+
 //
 // 画像ファイルを開く
 //
@@ -19,7 +43,7 @@ bool Capture::openImage(const std::string& filename)
   if (camImage->open(filename))
   {
     // このキャプチャデバイスを使うことにする
-    camera = std::move(camImage);
+    replace(std::move(camImage));
     return true;
   }
 
@@ -31,8 +55,24 @@ bool Capture::openImage(const std::string& filename)
 // 動画ファイルを開く
 //
 bool Capture::openMovie(const std::string& filename,
-  cv::VideoCaptureAPIs backend)
+  cv::VideoCaptureAPIs backend, bool yuv)
 {
+#if defined(USE_GSTREAMER)
+  // GStreamer のパイプラインなら
+  if (backend == cv::CAP_GSTREAMER)
+  {
+    // 新しいキャプチャデバイスを作成して
+    auto camGst{ std::make_unique<CamGst>() };
+
+    // パイプラインを直接開けたらそれを使う
+    if (camGst->open(filename, yuv))
+    {
+      replace(std::move(camGst));
+      return true;
+    }
+  }
+#endif
+
   // 新しいキャプチャデバイスを作成したら
   auto camCv{ std::make_unique<CamCv>() };
 
@@ -40,7 +80,7 @@ bool Capture::openMovie(const std::string& filename,
   if (camCv->open(filename, 0, 0, 0.0, "", backend))
   {
     // このキャプチャデバイスを使うことにする
-    camera = std::move(camCv);
+    replace(std::move(camCv));
     return true;
   }
 
@@ -48,20 +88,55 @@ bool Capture::openMovie(const std::string& filename,
   return false;
 }
 
+//
+// Video for Linux のキャプチャデバイスを直接開く
+//
+static std::unique_ptr<Camera> openV4l2(int deviceNumber, std::array<int, 2>& size, double& fps,
+  cv::VideoCaptureAPIs backend, char* fourcc, bool yuv)
+{
+#if defined(__linux__)
+  // Video for Linux で YUV のフレームを GPU で色変換するときだけ直接開く
+  if (backend != cv::CAP_V4L2 || !yuv) return nullptr;
+
+  // 新しいキャプチャデバイスを作成して
+  auto camV4l2{ std::make_unique<CamV4l2>() };
+
+  // このデバイスをデバイス番号で開いたら
+  if (camV4l2->open(deviceNumber, size[0], size[1], fps, fourcc))
+  {
+    // 実際に開いた設定を書き戻す
+    size = camV4l2->getSize();
+    fps = camV4l2->getFps();
+    camV4l2->getCodec(fourcc);
+    return camV4l2;
+  }
+#endif
+
+  // 直接開かなかった
+  return nullptr;
+}
+
 //
 // デバイスを開く
 //
 bool Capture::openDevice(int deviceNumber, std::array<int, 2>& size, double& fps,
-  cv::VideoCaptureAPIs backend, char* fourcc)
+  cv::VideoCaptureAPIs backend, char* fourcc, bool yuv, bool parallel)
 {
   // 既にカメラが有効なら一旦閉じる
   if (camera) camera->close();
 
+  // Video for Linux のキャプチャデバイスを直接開けたらそれを使う
+  if (auto camV4l2{ openV4l2(deviceNumber, size, fps, backend, fourcc, yuv) })
+  {
+    replace(std::move(camV4l2));
+    return true;
+  }
+
   // 新しいキャプチャデバイスを作成したら
   auto camCv{ std::make_unique<CamCv>() };
 
   // このデバイスをデバイス番号で開いて
-  if (camCv->open(deviceNumber, size[0], size[1], fps, fourcc, backend))
+  if (camCv->open(deviceNumber, size[0], size[1], fps, fourcc, backend, yuv, parallel))
   {
     // 実際に開いた設定を書き戻す
     size[0] = camCv->getWidth();
@@ -70,7 +145,48 @@ bool Capture::openDevice(int deviceNumber, std::array<int, 2>& size, double& fps
     camCv->getCodec(fourcc);
 
     // このキャプチャデバイスを使うことにする
-    camera = std::move(camCv);
+    replace(std::move(camCv));
+    return true;
+  }
+
+  // 開けなかった
+  return false;
+}
+
+//
+// 同時にキャプチャするキャプチャデバイスを追加する
+//
+bool Capture::addDevice(int deviceNumber, std::array<int, 2>& size, double& fps,
+  cv::VideoCaptureAPIs backend, char* fourcc, bool yuv, bool parallel)
+{
+  // 選択しているキャプチャデバイスがなければ追加しない
+  if (!camera) return false;
+
+  // Video for Linux のキャプチャデバイスを直接開けたらそれを追加する
+  if (auto camV4l2{ openV4l2(deviceNumber, size, fps, backend, fourcc, yuv) })
+  {
+    if (camera->isRunning()) camV4l2->start();
+    extras.emplace_back(std::move(camV4l2));
+    return true;
+  }
+
+  // 新しいキャプチャデバイスを作成したら
+  auto camCv{ std::make_unique<CamCv>() };
+
+  // このデバイスをデバイス番号で開いて
+  if (camCv->open(deviceNumber, size[0], size[1], fps, fourcc, backend, yuv, parallel))
+  {
+    // 実際に開いた設定を書き戻す
+    size[0] = camCv->getWidth();
+    size[1] = camCv->getHeight();
+    fps = camCv->getFps();
+    camCv->getCodec(fourcc);
+
+    // キャプチャ中ならこのキャプチャデバイスのキャプチャも開始する
+    if (camera->isRunning()) camCv->start();
+
+    // このキャプチャデバイスを追加する
+    extras.emplace_back(std::move(camCv));
     return true;
   }
 
@@ -85,6 +201,9 @@ void Capture::start()
 {
   // キャプチャデバイスが有効ならキャプチャスレッドを起動する
   if (camera) camera->start();
+
+  // 追加したキャプチャデバイスのキャプチャスレッドも起動する
+  for (auto& extra : extras) if (!extra->isRunning()) extra->start();
 }
 
 //
@@ -94,6 +213,9 @@ void Capture::stop()
 {
   // キャプチャデバイスが有効ならキャプチャスレッドを停止する
   if (camera) camera->stop();
+
+  // 追加したキャプチャデバイスのキャプチャスレッドも停止する
+  for (auto& extra : extras) extra->stop();
 }
 
 //
@@ -101,6 +223,9 @@ void Capture::stop()
 //
 void Capture::close()
 {
+  // 追加したキャプチャデバイスを閉じる
+  closeExtras();
+
   // キャプチャデバイスが有効ならキャプチャスレッドを停止する
   if (camera)
   {
@@ -130,15 +255,101 @@ double Capture::getFps() const
 //
 // フレームを取得する
 //
-void Capture::retrieve(Buffer& buffer)
+bool Capture::retrieve(Buffer& buffer)
 {
-  // キャプチャデバイスが有効なら
-  if (camera)
+  // キャプチャデバイスが無効なら何もしない
+  if (!camera) return false;
+
+  // バッファのサイズを取得したフレームのサイズに合わせて
+  buffer.create(camera->getWidth(), camera->getHeight(), camera->getChannels());
+
+  // バッファのピクセルバッファオブジェクトにフレームを転送する
+  return camera->transmit(buffer.getBufferName());
+}
+
+//
+// フレームを画素の格納形式とともに取得する
+//
+bool Capture::retrieve(Frame& frame)
+{
+  // キャプチャデバイスが無効なら何もしない
+  if (!camera) return false;
+
+  // フレームのサイズと画素の格納形式を取得したフレームに合わせて
+  frame.create(camera->getWidth(), camera->getHeight(), camera->getChannels(),
+    camera->getFrameFormat());
+
+  // フレームのピクセルバッファオブジェクトにフレームを転送する
+  if (!camera->transmit(frame.getBufferName())) return false;
+
+  // 転送したフレームの転送番号と取得した時刻を記録する
+  frame.setSequence(camera->getTransmittedSequence());
+  frame.setTimestamp(camera->getTransmittedTime());
+  return true;
+}
+
+//
+// すべてのキャプチャデバイスから時刻の揃ったフレームを取得する
+//
+bool Capture::retrieve(std::deque<Frame>& frames, double tolerance)
+{
+  // フレームの数をキャプチャデバイスの数に合わせる (少なくとも一つは残す)
+  const auto count{ getCount() };
+  while (frames.size() < count) frames.emplace_back();
+  while (frames.size() > std::max<size_t>(count, 1)) frames.pop_back();
+
+  // キャプチャデバイスが無効なら何もしない
+  if (count == 0) return false;
+
+  // キャプチャデバイスが一つならそのまま取得する
+  if (count == 1) return retrieve(frames.front());
+
+  // 新しいフレームを取得した時刻
+  std::vector<double> times(count);
+
+  // 取得した時刻の範囲
+  auto oldest{ std::numeric_limits<double>::max() };
+  auto newest{ std::numeric_limits<double>::lowest() };
+
+  // すべてのキャプチャデバイスについて
+  for (size_t i = 0; i < count; ++i)
   {
-    // バッファのサイズを取得したフレームのサイズに合わせて
-    buffer.create(camera->getWidth(), camera->getHeight(), camera->getChannels());
+    // 新しいフレームが取得されていなければ揃うのを待つ
+    times[i] = getCamera(i)->getCapturedTime();
+    if (times[i] < 0.0) return false;
 
-    // バッファのピクセルバッファオブジェクトにフレームを転送する
-    camera->transmit(buffer.getBufferName());
+    // 取得した時刻の範囲を求める
+    oldest = std::min(oldest, times[i]);
+    newest = std::max(newest, times[i]);
+  }
+
+  // 取得した時刻の差が許容範囲を超えていたら
+  if (newest - oldest > tolerance)
+  {
+    // 古すぎるフレームを捨てて次のフレームを待つ
+    for (size_t i = 0; i < count; ++i)
+    {
+      if (times[i] < newest - tolerance) getCamera(i)->skip();
+    }
+    return false;
   }
+
+  // すべてのキャプチャデバイスについて
+  for (size_t i = 0; i < count; ++i)
+  {
+    // フレームのサイズと画素の格納形式を取得したフレームに合わせて
+    const auto device{ getCamera(i) };
+    frames[i].create(device->getWidth(), device->getHeight(), device->getChannels(),
+      device->getFrameFormat());
+
+    // フレームのピクセルバッファオブジェクトにフレームを転送して転送番号と取得した時刻を記録する
+    if (device->transmit(frames[i].getBufferName()))
+    {
+      frames[i].setSequence(device->getTransmittedSequence());
+      frames[i].setTimestamp(device->getTransmittedTime());
+    }
+  }
+
+  // 時刻の揃ったフレームを取得した
+  return true;
 }
@@ -8,8 +8,8 @@
 /// @date Aplil 3, 2023
 ///
 
-// バッファクラス
-#include "Buffer.h"
+// フレームクラス
+#include "Frame.h"
 
 // OpenCV による画像ファイルの入力
 #include "CamImage.h"
@@ -17,6 +17,15 @@
 // OpenCV による動画の入力
 #include "CamCv.h"
 
+// Video for Linux による直接の入力
+#include "CamV4l2.h"
+
+// GStreamer の appsink による直接の入力
+#include "CamGst.h"
+
+// 標準ライブラリ
+#include <deque>
+
 ///
 /// キャプチャクラス
 ///
@@ -25,6 +34,35 @@ class Capture
   /// 選択しているキャプチャデバイスのポインタ
   std::unique_ptr<Camera> camera;
 
+  /// 同時にキャプチャするために追加したキャプチャデバイスのポインタ
+  std::vector<std::unique_ptr<Camera>> extras;
+
+  ///
+  /// キャプチャデバイスを取り出す
+  ///
+  /// @param index キャプチャデバイスの番号, 0 なら選択しているキャプチャデバイス
+  /// @return キャプチャデバイスのポインタ
+  ///
+  Camera* getCamera(size_t index) const
+  {
+    return index == 0 ? camera.get() : extras[index - 1].get();
+  }
+
+  ///
+  /// 選択しているキャプチャデバイスを置き換える
+  ///
+  /// @param newCamera 新しく選択するキャプチャデバイス
+  ///
+  /// @note
+  /// 追加したキャプチャデバイスは閉じる。
+  ///
+  void replace(std::unique_ptr<Camera>&& newCamera);
+
+  ///
+  /// 追加したキャプチャデバイスを閉じる
+  ///
+  void closeExtras();
+
 public:
 
   ///
@@ -58,6 +96,10 @@ public:
   /// @param 開く画像ファイル名
   /// @return 開くことができたら true
   ///
+  /// @note
+  /// 開くことができたら addDevice() で追加したキャプチャデバイスは閉じる。
+  /// openMovie() と openDevice() も同じ。
+  ///
   bool openImage(const std::string& filename);
 
   ///
@@ -65,10 +107,16 @@ public:
   ///
   /// @param filename 開く動画ファイル名
   /// @param backend バックエンドの種類
+  /// @param yuv YUV のフレームを GPU で色変換するなら true
   /// @return 開くことができたら true
   ///
+  /// @note
+  /// USE_GSTREAMER を定義していてバックエンドが GStreamer なら、
+  /// OpenCV を介さずにパイプラインの appsink のバッファから直接転送する。
+  /// パイプラインが開けなければ OpenCV で開く。
+  ///
   bool openMovie(const std::string& filename,
-    cv::VideoCaptureAPIs backend = cv::CAP_FFMPEG);
+    cv::VideoCaptureAPIs backend = cv::CAP_FFMPEG, bool yuv = false);
 
   ///
   /// キャプチャデバイスを開く
@@ -78,12 +126,39 @@ public:
   /// @param fps キャプチャデバイスのフレームレート
   /// @param backend バックエンドの種類
   /// @param fourcc コーデックの 4 文字
+  /// @param yuv YUV のフレームを GPU で色変換するなら true
+  /// @param parallel MJPEG のフレームを複数のスレッドで復号するなら true
   /// @return 開くことができたら true
   ///
+  /// @note
+  /// Linux でバックエンドが Video for Linux のとき YUV のフレームを GPU で色変換するなら、
+  /// OpenCV を介さずにキャプチャデバイスのバッファから直接転送する。
+  /// それができない形式なら OpenCV で開く。
+  ///
   bool openDevice(int deviceNumber,
     std::array<int, 2>& size, double& fps,
     cv::VideoCaptureAPIs backend = cv::CAP_FFMPEG,
-    char* fourcc = "");
+    char* fourcc = "", bool yuv = false, bool parallel = false);
+
+  ///
+  /// 同時にキャプチャするキャプチャデバイスを追加する
+  ///
+  /// @param deviceNumber 追加するデバイス番号
+  /// @param size キャプチャデバイスのフレームの解像度
+  /// @param fps キャプチャデバイスのフレームレート
+  /// @param backend バックエンドの種類
+  /// @param fourcc コーデックの 4 文字
+  /// @param yuv YUV のフレームを GPU で色変換するなら true
+  /// @param parallel MJPEG のフレームを複数のスレッドで復号するなら true
+  /// @return 追加できたら true
+  ///
+  /// @note
+  /// キャプチャ中なら追加したキャプチャデバイスのキャプチャも開始する。
+  ///
+  bool addDevice(int deviceNumber,
+    std::array<int, 2>& size, double& fps,
+    cv::VideoCaptureAPIs backend = cv::CAP_FFMPEG,
+    char* fourcc = "", bool yuv = false, bool parallel = false);
 
   ///
   /// キャプチャ開始
@@ -118,6 +193,28 @@ public:
     return bool(camera);
   }
 
+  ///
+  /// 同時にキャプチャしているキャプチャデバイスの数を得る
+  ///
+  /// @return キャプチャデバイスの数
+  ///
+  size_t getCount() const
+  {
+    return camera ? extras.size() + 1 : 0;
+  }
+
+  ///
+  /// すべてのキャプチャデバイスで転送しなかったフレームの数を得る
+  ///
+  /// @return 転送する前に次のフレームで置き換えたか捨てたフレームの数の合計
+  ///
+  unsigned long long getDroppedFrames() const
+  {
+    unsigned long long dropped{ 0 };
+    for (size_t i = 0; i < getCount(); ++i) dropped += getCamera(i)->getDroppedFrames();
+    return dropped;
+  }
+
   ///
   /// キャプチャデバイスのフレームの解像度を得る
   /// 
@@ -136,6 +233,31 @@ public:
   /// フレームを取得する
   ///
   /// @param buffer 取得したフレームを格納するバッファ
+  /// @return 新しいフレームを取得したら true
+  ///
+  bool retrieve(Buffer& buffer);
+
+  ///
+  /// フレームを画素の格納形式とともに取得する
+  ///
+  /// @param frame 取得したフレームを格納するフレーム
+  /// @return 新しいフレームを取得したら true
+  ///
+  bool retrieve(Frame& frame);
+
+  ///
+  /// すべてのキャプチャデバイスから時刻の揃ったフレームを取得する
+  ///
+  /// @param frames 取得したフレームをキャプチャデバイスごとに格納するフレーム
+  /// @param tolerance 同時に取得したとみなすフレームの時刻の差の上限（秒）
+  /// @return 時刻の揃ったフレームを取得したら true
+  ///
+  /// @note
+  /// frames の要素数はキャプチャデバイスの数に合わせる。
+  /// すべてのキャプチャデバイスで新しいフレームが取得されていて、
+  /// その時刻の差が tolerance 以下のときだけフレームを転送する。
+  /// 時刻の差が tolerance を超えていれば、最も新しいフレームより
+  /// tolerance 以上古いフレームを捨てて、次のフレームを待つ。
   ///
-  void retrieve(Buffer& buffer);
+  bool retrieve(std::deque<Frame>& frames, double tolerance = 0.02);
 };
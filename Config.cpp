@@ -9,6 +9,7 @@
 
 // 標準ライブラリ
 #include <fstream>
+#include <algorithm>
 
 //
 // デフォルトのビデオデバイスの一覧を作る
@@ -211,6 +212,9 @@ Config::Config(const std::string& filename)
   getMediaFoundationList(deviceList.at(cv::CAP_MSMF));
 #elif defined(__APPLE__)
   getAvFoundationList(deviceList.at(cv::CAP_AVFOUNDATION));
+#elif defined(__linux__)
+  v4l2DeviceList = enumerateV4l2Devices();
+  for (const auto& device : v4l2DeviceList) deviceList.at(cv::CAP_V4L2).emplace_back(device.name);
 #endif
 
   // 構成ファイルの保存場所を決定する
@@ -258,8 +262,9 @@ Config::~Config()
 //
 void Config::initialize()
 {
-  // 構成リストのすべて構成についてシェーダをビルドする
-  for (auto& preference : preferenceList) preference.buildShader();
+  // 展開用シェーダはそれぞれの構成を最初に使うときにビルドし、
+  // そのプログラムオブジェクトのバイナリを保存しておいて次回の起動時に使う
+  Expand::setCacheDirectory(shaderCache);
 
   // 背景色を設定する
   glClearColor(background[0], background[1], background[2], background[3]);
@@ -306,9 +311,39 @@ bool Config::load(const pathString& filename)
   // ArUco Marker の辞書名
   getString(object, "dictionary", settings.dictionaryName);
 
+  // ChArUco Board のマス目の数 (メニューと同じく３以上にする)
+  getValue(object, "board", settings.boardSquares);
+  for (auto& n : settings.boardSquares) n = std::max(n, 3);
+
+  // ArUco Marker の検出の設定
+  const auto& detector{ object.find("detector") };
+  if (detector != object.end() && detector->second.is<picojson::object>())
+    settings.detector = DetectorSettings{ detector->second.get<picojson::object>() };
+
+  // 同時に検出する追加の較正板の配置
+  const auto& boards{ object.find("boards") };
+  if (boards != object.end() && boards->second.is<picojson::array>())
+  {
+    settings.boards.clear();
+    for (const auto& board : boards->second.get<picojson::array>())
+    {
+      if (board.is<picojson::object>()) settings.boards.emplace_back(board.get<picojson::object>());
+    }
+  }
+
+  // フレームの表示方式
+  int presentation{ static_cast<int>(settings.presentation) };
+  if (getValue(object, "presentation", presentation)
+    && presentation >= static_cast<int>(Presentation::VSYNC)
+    && presentation <= static_cast<int>(Presentation::ON_FRAME))
+    settings.presentation = static_cast<Presentation>(presentation);
+
   // 初期表示画像
   getString(object, "initial", initialImage);
 
+  // 展開用シェーダのプログラムオブジェクトのバイナリの保存先
+  getString(object, "cache", shaderCache);
+
   // FFmpeg のリスト
   getString(object, "ffmpeg", deviceList[cv::CAP_FFMPEG]);
 
@@ -368,9 +403,26 @@ bool Config::save(const pathString& filename) const
   // ArUco Marker 辞書名
   setString(object, "dictionary", settings.dictionaryName);
 
+  // ChArUco Board のマス目の数
+  setValue(object, "board", settings.boardSquares);
+
+  // ArUco Marker の検出の設定
+  object.emplace("detector", picojson::value(settings.detector.getObject()));
+
+  // 同時に検出する追加の較正板の配置
+  picojson::array boards;
+  for (const auto& board : settings.boards) boards.emplace_back(board.getObject());
+  object.emplace("boards", picojson::value(boards));
+
+  // フレームの表示方式
+  setValue(object, "presentation", static_cast<int>(settings.presentation));
+
   // 初期表示画像
   setString(object, "initial", initialImage);
 
+  // 展開用シェーダのプログラムオブジェクトのバイナリの保存先
+  setString(object, "cache", shaderCache);
+
   // FFmpeg のリスト
   setString(object, "ffmpeg", deviceList.at(cv::CAP_FFMPEG));
 
@@ -405,6 +457,32 @@ bool Config::save(const pathString& filename) const
   return true;
 }
 
+//
+// キャプチャデバイスを開くときに使う番号を調べる
+//
+int Config::getDeviceIndex(cv::VideoCaptureAPIs api, int number) const
+{
+  // Video for Linux ならデバイスファイルの番号を使う
+  if (api == cv::CAP_V4L2 && number >= 0 && number < static_cast<int>(v4l2DeviceList.size()))
+    return v4l2DeviceList[number].index;
+
+  // それ以外はリストの番号をそのまま使う
+  return number;
+}
+
+//
+// キャプチャデバイスで最も高いスループットが得られる撮影モードを選ぶ
+//
+const V4l2Mode* Config::selectMode(cv::VideoCaptureAPIs api, int number,
+  const std::array<int, 2>& size, double fps) const
+{
+  // 撮影モードが分かるのは Video for Linux のキャプチャデバイスだけ
+  if (api != cv::CAP_V4L2 || number < 0 || number >= static_cast<int>(v4l2DeviceList.size()))
+    return nullptr;
+
+  return v4l2DeviceList[number].selectMode(size, fps);
+}
+
 // バックエンドのリスト
 const std::map<cv::VideoCaptureAPIs, const char*> Config::backendList
 {
@@ -413,6 +491,8 @@ const std::map<cv::VideoCaptureAPIs, const char*> Config::backendList
   { cv::CAP_DSHOW, "Direct Show" },
 #elif defined(__APPLE__)
   { cv::CAP_AVFOUNDATION, "AV Foundation" },
+#elif defined(__linux__)
+  { cv::CAP_V4L2, "Video for Linux" },
 #endif
   { cv::CAP_GSTREAMER, "GStreamer" },
   { cv::CAP_ANY, "(any)" },
@@ -427,12 +507,24 @@ const std::vector<const char*> Config::codecList
   "H264",
   "BGR3",
   "YUY2",
+  "YUYV",
   "I420",
   "NV12"
 };
 
+// フレームの表示方式のリスト
+const std::vector<const char*> Config::presentationList
+{
+  u8"垂直同期",
+  u8"無制限",
+  u8"フレーム到着時"
+};
+
 // キャプチャデバイスのリスト
 std::map <cv::VideoCaptureAPIs, std::vector<std::string>> Config::deviceList;
 
+// Video for Linux のキャプチャデバイスのリスト
+std::vector<V4l2Device> Config::v4l2DeviceList;
+
 // 初期表示の画像ファイル名
 std::string Config::initialImage{ "initial.jpg" };
@@ -11,9 +11,36 @@
 // キャプチャデバイスの構成
 #include "Preference.h"
 
+// ArUco Marker の検出の設定
+#include "DetectorSettings.h"
+
+// 追加の較正板の配置
+#include "BoardLayout.h"
+
+// Video for Linux のキャプチャデバイスの列挙
+#include "V4l2Device.h"
+
 // OpenCV
 #include <opencv2/opencv.hpp>
 
+///
+/// フレームの表示方式
+///
+/// @note
+/// 値は構成ファイルの "presentation" に保存する。
+///
+enum class Presentation : int
+{
+  /// 垂直同期に合わせて表示する
+  VSYNC = 0,
+
+  /// 垂直同期を待たずに表示する
+  UNCAPPED = 1,
+
+  /// 新しいフレームを取得したか入力イベントが発生したときだけ処理して表示する
+  ON_FRAME = 2
+};
+
 ///
 /// 表示関連の設定データ
 ///
@@ -49,6 +76,21 @@ struct Settings
   /// 検出する ArUco Marker の一辺の長さ (単位 cm)
   float markerLength;
 
+  /// 検出する ChArUco Board の横と縦のマス目の数
+  std::array<int, 2> boardSquares;
+
+  /// 検出する ChArUco Board のマス目の数のデフォルト値
+  static constexpr decltype(boardSquares) defaultBoardSquares{ 10, 7 };
+
+  /// ArUco Marker の検出の設定
+  DetectorSettings detector;
+
+  /// 同時に検出する追加の較正板の配置
+  std::vector<BoardLayout> boards;
+
+  /// フレームの表示方式
+  Presentation presentation;
+
   ///
   /// コンストラクタ
   ///
@@ -60,6 +102,8 @@ struct Settings
     , dictionaryName{ dictionaryName }
     , checkerLength{ 4.0f, 2.0f }
     , markerLength{ 5.0f }
+    , boardSquares{ defaultBoardSquares }
+    , presentation{ Presentation::VSYNC }
   {}
 
   ///
@@ -98,15 +142,24 @@ class Config
   /// メニューフォントサイズ
   float menuFontSize;
 
+  /// 展開用シェーダのプログラムオブジェクトのバイナリを保存するディレクトリ
+  std::string shaderCache;
+
   /// バックエンドのリスト
   static const std::map<cv::VideoCaptureAPIs, const char*> backendList;
 
   /// コーデックのリスト
   static const std::vector<const char*> codecList;
 
+  /// フレームの表示方式のリスト (Presentation の順)
+  static const std::vector<const char*> presentationList;
+
   /// キャプチャデバイスのリスト
   static std::map <cv::VideoCaptureAPIs, std::vector<std::string>> deviceList;
 
+  /// Video for Linux のキャプチャデバイスのリスト (deviceList[cv::CAP_V4L2] と同じ順)
+  static std::vector<V4l2Device> v4l2DeviceList;
+
   /// 初期表示の画像ファイル名
   static std::string initialImage;
 
@@ -210,6 +263,36 @@ public:
     return settings.checkerLength;
   }
 
+  ///
+  /// 検出する ChArUco Board の横と縦のマス目の数を得る
+  ///
+  /// @return 検出する ChArUco Board の横と縦のマス目の数
+  ///
+  const auto& getBoardSquares() const
+  {
+    return settings.boardSquares;
+  }
+
+  ///
+  /// ArUco Marker の検出の設定を得る
+  ///
+  /// @return ArUco Marker の検出の設定
+  ///
+  const auto& getDetector() const
+  {
+    return settings.detector;
+  }
+
+  ///
+  /// 同時に検出する追加の較正板の配置を得る
+  ///
+  /// @return 同時に検出する追加の較正板の配置のリスト
+  ///
+  const auto& getBoards() const
+  {
+    return settings.boards;
+  }
+
   ///
   /// 検出する ArUco Marker の一辺の長さを得る
   ///
@@ -255,4 +338,28 @@ public:
     const auto& list{ deviceList.at(api) };
     return list.empty() ? empty : list[number];
   }
+
+  ///
+  /// キャプチャデバイスを開くときに使う番号を調べる
+  ///
+  /// @param api 使用しているバックエンドの API 名
+  /// @param number キャプチャデバイスのリストの番号
+  /// @return キャプチャデバイスを開くときに使う番号
+  ///
+  /// @note
+  /// Video for Linux ではデバイスファイルの番号 (/dev/videoN の N) を返す。
+  ///
+  int getDeviceIndex(cv::VideoCaptureAPIs api, int number) const;
+
+  ///
+  /// キャプチャデバイスで最も高いスループットが得られる撮影モードを選ぶ
+  ///
+  /// @param api 使用しているバックエンドの API 名
+  /// @param number キャプチャデバイスのリストの番号
+  /// @param size 期待するフレームの横と縦の画素数
+  /// @param fps 期待するフレームレート
+  /// @return 選んだ撮影モードのポインタ, 撮影モードが分からなければ nullptr
+  ///
+  const V4l2Mode* selectMode(cv::VideoCaptureAPIs api, int number,
+    const std::array<int, 2>& size, double fps) const;
 };
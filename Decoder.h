@@ -0,0 +1,266 @@
+﻿#pragma once
+
+///
+/// 圧縮フレームを並列に復号するクラスの定義
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 19, 2026
+///
+
+// OpenCV
+#include <opencv2/opencv.hpp>
+
+// 標準ライブラリ
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+///
+/// 圧縮フレームを並列に復号するクラス
+///
+/// @description
+/// キャプチャスレッドから受け取った MJPEG などの圧縮フレームを
+/// 複数のワーカスレッドで復号し、受け取った順に呼び出し元に渡す。
+/// 復号が追いつかなければ、まだ復号を始めていない古いフレームを捨てる。
+/// 捨てたフレームの数は次に受け渡すフレームとともに呼び出し元に知らせる。
+///
+class Decoder
+{
+  /// 復号したフレームとその直前に捨てたフレームの数を受け取る関数
+  const std::function<void(cv::Mat&, unsigned long long)> deliver;
+
+  /// 受け渡すフレームとその直前に捨てたフレームの数の並び
+  using Ready = std::vector<std::pair<cv::Mat, unsigned long long>>;
+
+  /// 復号を待っている圧縮フレームと通し番号
+  std::deque<std::pair<unsigned long long, std::vector<uchar>>> pending;
+
+  /// 復号が終わって受け渡しを待っているフレーム
+  std::map<unsigned long long, cv::Mat> decoded;
+
+  /// 次に受け取る圧縮フレームの通し番号
+  unsigned long long nextPacket;
+
+  /// 次に受け渡すフレームの通し番号
+  unsigned long long nextFrame;
+
+  /// 復号を待つ圧縮フレームの最大数
+  const size_t limit;
+
+  /// 前回フレームを受け渡してから捨てたフレームの数
+  unsigned long long skipped;
+
+  /// 次に取り出したフレームの受け渡しに割り当てる順番
+  unsigned long long nextTicket;
+
+  /// 次に受け渡しを行う順番
+  unsigned long long nextTurn;
+
+  /// ワーカスレッド
+  std::vector<std::thread> workers;
+
+  /// 復号待ちと受け渡し待ちのフレームを保護するミューテックス
+  std::mutex mtx;
+
+  /// 受け渡しを行う順番を保護するミューテックス
+  std::mutex deliveryMtx;
+
+  /// 復号を待っている圧縮フレームがあることを通知する条件変数
+  std::condition_variable ready;
+
+  /// 受け渡しを行う順番が進んだことを通知する条件変数
+  std::condition_variable turned;
+
+  /// ワーカスレッドが実行中なら true
+  bool running;
+
+  ///
+  /// 通し番号順に揃ったフレームを取り出す
+  ///
+  /// @param frames 取り出したフレームとその直前に捨てたフレームの数の格納先
+  ///
+  /// @note
+  /// mtx をロックした状態で呼び出す。
+  ///
+  void collect(Ready& frames)
+  {
+    // 次に受け渡すフレームの復号が終わっている間
+    for (auto it{ decoded.begin() }; it != decoded.end() && it->first == nextFrame;
+      it = decoded.erase(it), ++nextFrame)
+    {
+      // 捨てたか復号できなかったフレームは数えるだけにする
+      if (it->second.empty()) ++skipped;
+      else frames.emplace_back(std::move(it->second), std::exchange(skipped, 0));
+    }
+  }
+
+  ///
+  /// 取り出したフレームを受け渡す
+  ///
+  /// @param lock mtx をロックしている unique_lock
+  /// @param frames 受け渡すフレームとその直前に捨てたフレームの数
+  ///
+  /// @note
+  /// mtx をロックしている間に受け渡しの順番を取ってから mtx のロックを解除し、
+  /// その順番が来るまで待ってから受け渡す。順番を待つ間も受け渡し先でのコピーの間も
+  /// mtx はロックしていないので、submit() や他のワーカスレッドの復号と格納は止まらない。
+  ///
+  void handOver(std::unique_lock<std::mutex>& lock, Ready& frames)
+  {
+    // 受け渡すフレームがなければロックを解除するだけにする
+    if (frames.empty())
+    {
+      lock.unlock();
+      return;
+    }
+
+    // 取り出した順に受け渡しの順番を取ってから復号待ちと受け渡し待ちのフレームを解放する
+    const auto ticket{ nextTicket++ };
+    lock.unlock();
+
+    // 受け渡しの順番が来るまで待つ
+    std::unique_lock delivery{ deliveryMtx };
+    turned.wait(delivery, [this, ticket] { return nextTurn == ticket; });
+
+    // 取り出した順に受け渡す
+    for (auto& frame : frames) deliver(frame.first, frame.second);
+    frames.clear();
+
+    // 次の順番のスレッドを起こす
+    ++nextTurn;
+    delivery.unlock();
+    turned.notify_all();
+  }
+
+  ///
+  /// ワーカスレッドで圧縮フレームを復号する
+  ///
+  void work()
+  {
+    // 復号中の圧縮フレーム
+    std::pair<unsigned long long, std::vector<uchar>> packet;
+
+    // 受け渡すフレーム
+    Ready frames;
+
+    for (;;)
+    {
+      {
+        // 復号を待っている圧縮フレームを取り出す
+        std::unique_lock lock{ mtx };
+        ready.wait(lock, [this] { return !running || !pending.empty(); });
+        if (!running) return;
+        packet = std::move(pending.front());
+        pending.pop_front();
+      }
+
+      // 圧縮フレームを復号する
+      cv::Mat image{ cv::imdecode(packet.second, cv::IMREAD_COLOR) };
+
+      // 復号したフレームを並べ替えて通し番号順に揃ったものを受け渡す
+      std::unique_lock lock{ mtx };
+      decoded.emplace(packet.first, std::move(image));
+      collect(frames);
+      handOver(lock, frames);
+    }
+  }
+
+public:
+
+  ///
+  /// コンストラクタ
+  ///
+  /// @param deliver 復号したフレームとその直前に捨てたフレームの数を通し番号順に受け取る関数
+  /// @param threads ワーカスレッドの数, 0 ならハードウェアのスレッド数の半分 (2 以上 4 以下)
+  ///
+  /// @note
+  /// deliver は復号待ちのフレームのロックを解除してから呼び出すので、
+  /// その中で時間のかかるコピーを行っても他のワーカスレッドの復号を妨げない。
+  ///
+  Decoder(const std::function<void(cv::Mat&, unsigned long long)>& deliver, int threads = 0)
+    : deliver{ deliver }
+    , nextPacket{ 0 }
+    , nextFrame{ 0 }
+    , limit{ static_cast<size_t>(threads > 0 ? threads
+      : std::clamp(static_cast<int>(std::thread::hardware_concurrency()) / 2, 2, 4)) * 2 }
+    , skipped{ 0 }
+    , nextTicket{ 0 }
+    , nextTurn{ 0 }
+    , running{ true }
+  {
+    // ワーカスレッドを起動する
+    for (size_t i = 0; i < limit / 2; ++i) workers.emplace_back([this] { work(); });
+  }
+
+  ///
+  /// コピーコンストラクタは使用しない
+  ///
+  /// @param decoder コピー元
+  ///
+  Decoder(const Decoder& decoder) = delete;
+
+  ///
+  /// デストラクタ
+  ///
+  virtual ~Decoder()
+  {
+    {
+      // ワーカスレッドのループを止めて
+      std::lock_guard lock{ mtx };
+      running = false;
+    }
+    ready.notify_all();
+
+    // 合流する
+    for (auto& worker : workers) worker.join();
+  }
+
+  ///
+  /// 代入演算子は使用しない
+  ///
+  /// @param decoder 代入元
+  ///
+  Decoder& operator=(const Decoder& decoder) = delete;
+
+  ///
+  /// 圧縮フレームの復号を依頼する
+  ///
+  /// @param packet 圧縮フレームのデータ
+  ///
+  void submit(const cv::Mat& packet)
+  {
+    // 最も古い圧縮フレームを捨てたことで受け渡せるようになったフレーム
+    Ready frames;
+
+    {
+      std::unique_lock lock{ mtx };
+
+      // 復号が追いついていなければ
+      if (pending.size() >= limit)
+      {
+        // 最も古い圧縮フレームを捨てて、その通し番号は空のフレームとして扱う
+        decoded.emplace(pending.front().first, cv::Mat{});
+        pending.pop_front();
+        collect(frames);
+      }
+
+      // 圧縮フレームのデータをコピーして復号待ちに加える
+      const auto data{ packet.ptr<uchar>() };
+      pending.emplace_back(nextPacket++,
+        std::vector<uchar>(data, data + packet.total() * packet.elemSize()));
+
+      // 受け渡せるようになったフレームがあれば受け渡す
+      handOver(lock, frames);
+    }
+
+    // ワーカスレッドの一つを起こす
+    ready.notify_one();
+  }
+};
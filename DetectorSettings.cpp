@@ -0,0 +1,150 @@
+﻿///
+/// ArUco Marker の検出の設定の実装
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 19, 2026
+///
+#include "DetectorSettings.h"
+
+// 標準ライブラリ
+#include <string>
+#include <algorithm>
+
+//
+// 構成ファイルを読み込むときに使うコンストラクタ
+//
+DetectorSettings::DetectorSettings(const picojson::object& object)
+  : DetectorSettings{}
+{
+  // プリセットの名前
+  std::string preset;
+  if (getString(object, "preset", preset))
+  {
+    // 名前が一致するプリセットの設定にする
+    for (int i = 0; i < static_cast<int>(presetList.size()); ++i)
+    {
+      if (preset == presetList[i]) setPreset(i);
+    }
+  }
+
+  // 適応的二値化の窓の大きさ (メニューと同じく窓の大きさは３以上、増分は１以上にする)
+  getValue(object, "adaptiveThreshWinSize", adaptiveThreshWinSize);
+  adaptiveThreshWinSize[0] = std::max(adaptiveThreshWinSize[0], 3);
+  adaptiveThreshWinSize[1] = std::max(adaptiveThreshWinSize[1], adaptiveThreshWinSize[0]);
+  adaptiveThreshWinSize[2] = std::max(adaptiveThreshWinSize[2], 1);
+
+  // コーナーの位置の補正方法
+  getValue(object, "cornerRefinementMethod", cornerRefinementMethod);
+  cornerRefinementMethod = std::min(std::max(cornerRefinementMethod, 0), 3);
+
+  // マーカの候補の周長の最小の比率
+  getValue(object, "minMarkerPerimeterRate", minMarkerPerimeterRate);
+  minMarkerPerimeterRate = std::max(minMarkerPerimeterRate, 0.0f);
+
+  // ArUco3 の高速な検出
+  int aruco3{ useAruco3Detection ? 1 : 0 };
+  if (getValue(object, "useAruco3Detection", aruco3)) useAruco3Detection = aruco3 != 0;
+
+  // ArUco3 で縮小した画像上のマーカの一辺の最小の長さ
+  getValue(object, "minSideLengthCanonicalImg", minSideLengthCanonicalImg);
+  minSideLengthCanonicalImg = std::max(minSideLengthCanonicalImg, 1);
+
+  // ArUco3 で前のフレームからマーカが縮小する割合の見込み
+  getValue(object, "cameraMotionSpeed", cameraMotionSpeed);
+  cameraMotionSpeed = std::min(std::max(cameraMotionSpeed, 0.0f), 1.0f);
+
+  // ChArUco Board のコーナーのサブピクセル精度の補正
+  getValue(object, "subPixelWindow", subPixelWindow);
+  subPixelWindow = std::max(subPixelWindow, 0);
+  getValue(object, "subPixelIterations", subPixelIterations);
+  subPixelIterations = std::max(subPixelIterations, 1);
+}
+
+//
+// プリセットの設定にする
+//
+void DetectorSettings::setPreset(int preset)
+{
+  switch (preset)
+  {
+  case 0:
+    // fast: 窓の大きさは２段だけにして小さな候補は捨て、ArUco3 で検出する
+    adaptiveThreshWinSize = { 7, 27, 20 };
+    cornerRefinementMethod = 0;
+    minMarkerPerimeterRate = 0.1f;
+    useAruco3Detection = true;
+    minSideLengthCanonicalImg = 16;
+    cameraMotionSpeed = 0.1f;
+    subPixelWindow = 0;
+    subPixelIterations = 30;
+    break;
+
+  case 2:
+    // accurate: 窓の大きさを細かく変えてコーナーの位置をサブピクセル精度で補正する
+    adaptiveThreshWinSize = { 3, 33, 5 };
+    cornerRefinementMethod = 1;
+    minMarkerPerimeterRate = 0.02f;
+    useAruco3Detection = false;
+    minSideLengthCanonicalImg = 32;
+    cameraMotionSpeed = 0.1f;
+    subPixelWindow = 5;
+    subPixelIterations = 30;
+    break;
+
+  default:
+    // balanced: OpenCV のデフォルト値
+    adaptiveThreshWinSize = { 3, 23, 10 };
+    cornerRefinementMethod = 0;
+    minMarkerPerimeterRate = 0.03f;
+    useAruco3Detection = false;
+    minSideLengthCanonicalImg = 32;
+    cameraMotionSpeed = 0.1f;
+    subPixelWindow = 0;
+    subPixelIterations = 30;
+    break;
+  }
+}
+
+//
+// 現在の設定に一致するプリセットの番号を得る
+//
+int DetectorSettings::getPreset() const
+{
+  // すべてのプリセットについて
+  for (int i = 0; i < static_cast<int>(presetList.size()); ++i)
+  {
+    // プリセットの設定と比較する
+    DetectorSettings preset;
+    preset.setPreset(i);
+    if (preset == *this) return i;
+  }
+
+  // 一致するプリセットがない
+  return -1;
+}
+
+//
+// 構成ファイルに保存する JSON オブジェクトを得る
+//
+picojson::object DetectorSettings::getObject() const
+{
+  // 構成ファイルの JSON オブジェクト
+  picojson::object object;
+
+  // プリセットに一致していればその名前も保存しておく
+  const auto preset{ getPreset() };
+  if (preset >= 0) setString(object, "preset", presetList[preset]);
+
+  // 個々の設定
+  setValue(object, "adaptiveThreshWinSize", adaptiveThreshWinSize);
+  setValue(object, "cornerRefinementMethod", cornerRefinementMethod);
+  setValue(object, "minMarkerPerimeterRate", minMarkerPerimeterRate);
+  setValue(object, "useAruco3Detection", useAruco3Detection ? 1 : 0);
+  setValue(object, "minSideLengthCanonicalImg", minSideLengthCanonicalImg);
+  setValue(object, "cameraMotionSpeed", cameraMotionSpeed);
+  setValue(object, "subPixelWindow", subPixelWindow);
+  setValue(object, "subPixelIterations", subPixelIterations);
+
+  return object;
+}
@@ -0,0 +1,117 @@
+﻿#pragma once
+
+///
+/// ArUco Marker の検出の設定の定義
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 19, 2026
+///
+
+// 構成ファイルの読み取り補助
+#include "parseconfig.h"
+
+// 標準ライブラリ
+#include <array>
+
+///
+/// ArUco Marker の検出の設定
+///
+/// @description
+/// cv::aruco::DetectorParameters のうち処理時間に大きく影響するものを保持する。
+/// デフォルトコンストラクタは OpenCV のデフォルト値 ("balanced") にする。
+///
+struct DetectorSettings
+{
+  /// 適応的二値化の窓の大きさの最小値・最大値・増分 (画素)
+  std::array<int, 3> adaptiveThreshWinSize;
+
+  /// コーナーの位置の補正方法 (cv::aruco::CornerRefineMethod)
+  int cornerRefinementMethod;
+
+  /// マーカの候補の周長の画像の大きさに対する最小の比率
+  float minMarkerPerimeterRate;
+
+  /// ArUco3 の高速な検出を使うなら true
+  bool useAruco3Detection;
+
+  /// ArUco3 で縮小した画像上のマーカの一辺の最小の長さ (画素, １以上)
+  int minSideLengthCanonicalImg;
+
+  /// ArUco3 で前のフレームからマーカが縮小する割合の見込み (0～1)
+  float cameraMotionSpeed;
+
+  /// ChArUco Board のコーナーをサブピクセル精度で補正する窓の大きさの半分 (画素, 0 なら補正しない)
+  int subPixelWindow;
+
+  /// ChArUco Board のコーナーのサブピクセル精度の補正の最大の繰り返し回数
+  int subPixelIterations;
+
+  /// プリセットの名前 (構成ファイルで使う)
+  static constexpr std::array<const char*, 3> presetList{ "fast", "balanced", "accurate" };
+
+  /// デフォルトのプリセットの番号
+  static constexpr int defaultPreset{ 1 };
+
+  ///
+  /// デフォルトコンストラクタ
+  ///
+  DetectorSettings()
+  {
+    setPreset(defaultPreset);
+  }
+
+  ///
+  /// 構成ファイルを読み込むときに使うコンストラクタ
+  ///
+  /// @param object 構成ファイルの JSON オブジェクト
+  ///
+  /// @note
+  /// "preset" があればそのプリセットを元にして、個々の設定があればそれで置き換える。
+  ///
+  DetectorSettings(const picojson::object& object);
+
+  ///
+  /// プリセットの設定にする
+  ///
+  /// @param preset プリセットの番号 (presetList の添え字)
+  ///
+  /// @note
+  /// fast は窓の大きさの段数を減らして小さな候補を捨て、ArUco3 で縮小した画像で検出する。
+  /// accurate は窓の大きさの段数を増やしてマーカと ChArUco Board のコーナーの位置を
+  /// サブピクセル精度で補正する。
+  ///
+  void setPreset(int preset);
+
+  ///
+  /// 現在の設定に一致するプリセットの番号を得る
+  ///
+  /// @return 一致するプリセットの番号, 一致するものがなければ -1
+  ///
+  int getPreset() const;
+
+  ///
+  /// 構成ファイルに保存する JSON オブジェクトを得る
+  ///
+  /// @return 構成ファイルの JSON オブジェクト
+  ///
+  picojson::object getObject() const;
+
+  ///
+  /// 設定を比較する
+  ///
+  /// @param settings 比較する設定
+  /// @return 設定がすべて同じなら true
+  ///
+  bool operator==(const DetectorSettings& settings) const
+  {
+    return adaptiveThreshWinSize == settings.adaptiveThreshWinSize
+      && cornerRefinementMethod == settings.cornerRefinementMethod
+      && minMarkerPerimeterRate == settings.minMarkerPerimeterRate
+      && useAruco3Detection == settings.useAruco3Detection
+      && minSideLengthCanonicalImg == settings.minSideLengthCanonicalImg
+      && cameraMotionSpeed == settings.cameraMotionSpeed
+      && subPixelWindow == settings.subPixelWindow
+      && subPixelIterations == settings.subPixelIterations;
+  }
+};
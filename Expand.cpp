@@ -4,20 +4,242 @@
 #include "Expand.h"
 
 // 標準ライブラリ
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
 #include <stdexcept>
+#include <vector>
+
+//
+// ファイルを文字列に読み込む
+//
+static bool readSource(const std::string& name, std::string& src)
+{
+  std::ifstream file{ name, std::ios::binary };
+  if (!file) return false;
+  src.assign(std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{});
+  return !file.bad();
+}
+
+//
+// 文字列のハッシュ値を求める (FNV-1a)
+//
+static std::uint64_t hashString(const std::string& str, std::uint64_t hash = 14695981039346656037ull)
+{
+  for (const auto c : str)
+  {
+    hash ^= static_cast<unsigned char>(c);
+    hash *= 1099511628211ull;
+  }
+  return hash;
+}
+
+//
+// ドライバの識別文字列を得る
+//
+static std::string getDriverString()
+{
+  std::string driver;
+  for (const auto name : { GL_VENDOR, GL_RENDERER, GL_VERSION })
+  {
+    const auto str{ reinterpret_cast<const char*>(glGetString(name)) };
+    if (str) driver.append(str);
+    driver.push_back('\n');
+  }
+  return driver;
+}
+
+//
+// プログラムオブジェクトのバイナリを読み込む
+//
+static GLuint loadProgramBinary(const std::string& path)
+{
+  // プログラムオブジェクトのバイナリのファイルを開く
+  std::ifstream file{ path, std::ios::binary };
+  if (!file) return 0;
+
+  // バイナリの形式と内容を読み込む
+  GLenum format;
+  if (!file.read(reinterpret_cast<char*>(&format), sizeof format)) return 0;
+  const std::vector<char> binary{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+  if (binary.empty()) return 0;
+
+  // プログラムオブジェクトにバイナリを読み込む
+  const auto program{ glCreateProgram() };
+  glProgramBinary(program, format, binary.data(), static_cast<GLsizei>(binary.size()));
+
+  // ドライバが更新されたなどでバイナリが使えなければ削除する
+  GLint status;
+  glGetProgramiv(program, GL_LINK_STATUS, &status);
+  if (status == GL_FALSE)
+  {
+    glDeleteProgram(program);
+    return 0;
+  }
+
+  return program;
+}
+
+//
+// プログラムオブジェクトのバイナリを保存する
+//
+static void saveProgramBinary(GLuint program, const std::string& path)
+{
+  // プログラムオブジェクトのバイナリを取り出す
+  GLint length{ 0 };
+  glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+  if (length <= 0) return;
+  std::vector<char> binary(length);
+  GLenum format;
+  glGetProgramBinary(program, length, &length, &format, binary.data());
+  if (length <= 0) return;
+
+  // 保存先のディレクトリを作って書き出す
+  std::error_code error;
+  std::filesystem::create_directories(std::filesystem::path{ path }.parent_path(), error);
+  std::ofstream file{ path, std::ios::binary };
+  if (!file) return;
+  file.write(reinterpret_cast<const char*>(&format), sizeof format);
+  file.write(binary.data(), length);
+}
+
+//
+// フラグメントシェーダの #version 指令の直後に共通のサンプリング関数を挿入する
+//
+static bool insertSampler(const std::string& frag, std::string& fsrc)
+{
+  // 共通のサンプリング関数はフラグメントシェーダと同じディレクトリの sample.glsl に置く
+  std::string sample;
+  const auto path{ std::filesystem::path{ frag }.parent_path() / "sample.glsl" };
+  if (!readSource(path.string(), sample)) return false;
+
+  // #version 指令の行の直後に挿入して、後続の行番号を元のソースプログラムに合わせる
+  const auto end{ fsrc.find('\n') };
+  if (end == std::string::npos) return false;
+  fsrc.insert(end + 1, sample + "\n#line 2\n");
+  return true;
+}
+
+//
+// シェーダのソースプログラムをコンパイルする
+//
+static GLuint compileShader(GLenum type, const std::string& src, const std::string& name)
+{
+  // シェーダオブジェクトを作成してコンパイルする
+  const auto shader{ glCreateShader(type) };
+  const GLchar* srcp{ src.c_str() };
+  glShaderSource(shader, 1, &srcp, nullptr);
+  glCompileShader(shader);
+
+  // コンパイルに失敗したら削除する
+  GLint status;
+  glGetShaderiv(shader, GL_COMPILE_STATUS, &status);
+  if (status == GL_FALSE)
+  {
+#if defined(DEBUG)
+    GLsizei length;
+    glGetShaderiv(shader, GL_INFO_LOG_LENGTH, &length);
+    std::vector<GLchar> infoLog(std::max(length, 1));
+    glGetShaderInfoLog(shader, static_cast<GLsizei>(infoLog.size()), nullptr, infoLog.data());
+    std::cerr << "Compile Error in " << name << std::endl << infoLog.data();
+#endif
+    glDeleteShader(shader);
+    return 0;
+  }
+
+  return shader;
+}
+
+//
+// バイナリを取り出せるようにプログラムオブジェクトを作成する
+//
+static GLuint createRetrievableProgram(const std::string& vsrc, const std::string& fsrc,
+  const std::string& vert, const std::string& frag)
+{
+  // シェーダをコンパイルする
+  const auto vertShader{ compileShader(GL_VERTEX_SHADER, vsrc, vert) };
+  const auto fragShader{ compileShader(GL_FRAGMENT_SHADER, fsrc, frag) };
+
+  // 両方ともコンパイルできたらバイナリを取り出せるようにヒントを与えてから一度だけリンクする
+  GLuint program{ 0 };
+  if (vertShader != 0 && fragShader != 0)
+  {
+    program = glCreateProgram();
+    glAttachShader(program, vertShader);
+    glAttachShader(program, fragShader);
+    glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glLinkProgram(program);
+
+    // リンクに失敗したら削除する
+    GLint status;
+    glGetProgramiv(program, GL_LINK_STATUS, &status);
+    if (status == GL_FALSE)
+    {
+#if defined(DEBUG)
+      std::cerr << "Link Error in " << vert << " and " << frag << std::endl;
+#endif
+      glDeleteProgram(program);
+      program = 0;
+    }
+  }
+
+  // シェーダオブジェクトはプログラムオブジェクトが削除されるときに削除されるようにする
+  glDeleteShader(vertShader);
+  glDeleteShader(fragShader);
+
+  return program;
+}
+
+//
+// 展開用シェーダのプログラムオブジェクトを作成する
+//
+static GLuint loadProgram(const std::string& vert, const std::string& frag, const std::string& cache)
+{
+  // シェーダのソースプログラムを読み込んで共通のサンプリング関数を挿入する
+  // (sampleImage() を使うので挿入できなければプログラムオブジェクトは作れない)
+  std::string vsrc, fsrc;
+  if (!readSource(vert, vsrc) || !readSource(frag, fsrc) || !insertSampler(frag, fsrc)) return 0;
+
+  // プログラムオブジェクトのバイナリを保存しないかドライバが対応していなければビルドする
+  GLint formats{ 0 };
+  glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+  if (cache.empty() || formats <= 0) return gg::ggCreateShader(vsrc, fsrc, "", 0, nullptr, vert, frag);
+
+  // ソースプログラムとドライバの識別文字列のハッシュ値をバイナリのファイル名にする
+  const auto hash{ hashString(getDriverString(), hashString(fsrc, hashString(vsrc + '\0'))) };
+  char name[24];
+  std::snprintf(name, sizeof name, "%016llx.bin", static_cast<unsigned long long>(hash));
+  const auto path{ (std::filesystem::path{ cache } / name).string() };
+
+  // 保存されたバイナリが使えればそれを使う
+  const auto binary{ loadProgramBinary(path) };
+  if (binary != 0) return binary;
+
+  // バイナリを取り出せるようにシェーダをビルドしてそのバイナリを保存する
+  const auto program{ createRetrievableProgram(vsrc, fsrc, vert, frag) };
+  if (program != 0) saveProgramBinary(program, path);
+  return program;
+}
 
 //
 //  コンストラクタ
 //
 Expand::Expand(const std::string& vert, const std::string& frag)
-  : program{ gg::ggLoadShader(vert, frag) }
+  : program{ loadProgram(vert, frag, cacheDirectory) }
   , imageLoc{ glGetUniformLocation(program, "image") }
+  , chromaLoc{ glGetUniformLocation(program, "chroma") }
+  , formatLoc{ glGetUniformLocation(program, "format") }
   , screenLoc{ glGetUniformLocation(program, "screen") }
   , focalLoc{ glGetUniformLocation(program, "focal") }
   , rotationLoc{ glGetUniformLocation(program, "rotation") }
   , circleLoc{ glGetUniformLocation(program, "circle") }
   , borderLoc{ glGetUniformLocation(program, "border") }
   , gapLoc{ glGetUniformLocation(program, "gap") }
+  , flipLoc{ glGetUniformLocation(program, "flip") }
 {
   // プログラムオブジェクトが作れなかったら落とす
   if (program == 0) throw std::runtime_error("Cannot create one of the expand shader.");
@@ -36,7 +258,7 @@ Expand::~Expand()
 ///
 std::array<int, 2> Expand::setup(int samples, GLfloat aspect, const gg::GgMatrix& pose,
   const std::array<GLfloat, 2>& fov, const std::array<GLfloat, 2>& center, GLfloat focal,
-  const std::array<GLfloat, 4>& border, int unit) const
+  const std::array<GLfloat, 4>& border, FrameFormat format, int unit, bool flip) const
 {
   // プログラムオブジェクトの指定
   glUseProgram(program);
@@ -44,6 +266,10 @@ std::array<int, 2> Expand::setup(int samples, GLfloat aspect, const gg::GgMatrix
   // テクスチャユニットの指定
   glUniform1i(imageLoc, unit);
 
+  // 色差のテクスチャユニットと画素の格納形式の指定
+  glUniform1i(chromaLoc, unit + 1);
+  glUniform1i(formatLoc, static_cast<GLint>(format));
+
   // 境界色
   glUniform4fv(borderLoc, 1, border.data());
 
@@ -61,6 +287,9 @@ std::array<int, 2> Expand::setup(int samples, GLfloat aspect, const gg::GgMatrix
   // レンズの主点とスクリーンの距離
   glUniform1f(focalLoc, focal);
 
+  // 表示領域に直接描くなら上下を反転する
+  glUniform1i(flipLoc, flip ? 1 : 0);
+
   // 背景に対する視線の回転行列
   glUniformMatrix4fv(rotationLoc, 1, GL_FALSE, pose.get());
 
@@ -80,3 +309,6 @@ std::array<int, 2> Expand::setup(int samples, GLfloat aspect, const gg::GgMatrix
   // 描画するメッシュの横と縦の格子点数を返す
   return std::array<int, 2>{ w, h };
 }
+
+// プログラムオブジェクトのバイナリを保存するディレクトリ
+std::string Expand::cacheDirectory;
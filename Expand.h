@@ -11,6 +11,9 @@
 // 補助プログラム
 #include "gg.h"
 
+// フレームの画素の格納形式
+#include "Buffer.h"
+
 ///
 /// 展開用シェーダクラス
 ///
@@ -22,6 +25,12 @@ class Expand
   /// 投影像のサンプラの uniform 変数の場所
   const GLint imageLoc;
 
+  /// 投影像の色差のサンプラの uniform 変数の場所
+  const GLint chromaLoc;
+
+  /// 投影像の画素の格納形式の uniform 変数の場所
+  const GLint formatLoc;
+
   /// スクリーンの投影範囲の uniform 変数の場所
   const GLint screenLoc;
 
@@ -40,14 +49,39 @@ class Expand
   /// スクリーンの格子間隔の uniform 変数の場所
   const GLint gapLoc;
 
+  /// 上下を反転して描くかどうかの uniform 変数の場所
+  const GLint flipLoc;
+
+  /// プログラムオブジェクトのバイナリを保存するディレクトリ
+  static std::string cacheDirectory;
+
 public:
 
+  ///
+  /// プログラムオブジェクトのバイナリを保存するディレクトリを設定する
+  ///
+  /// @param directory プログラムオブジェクトのバイナリを保存するディレクトリ名
+  ///
+  /// @note
+  /// 空文字列ならプログラムオブジェクトのバイナリを保存せずに毎回ビルドする。
+  ///
+  static void setCacheDirectory(const std::string& directory)
+  {
+    cacheDirectory = directory;
+  }
+
   ///
   /// コンストラクタ
   ///
   /// @param vert バーテックスシェーダのソースファイル名
   /// @param frag フラグメントシェーダのソースファイル名
   ///
+  /// @note
+  /// フラグメントシェーダには同じディレクトリの sample.glsl に定義した
+  /// テクスチャのサンプリング関数 sampleImage() を #version 指令の直後に挿入する。
+  /// ソースプログラムとドライバが同じプログラムオブジェクトのバイナリが
+  /// 保存されていれば、シェーダをコンパイルせずにそれを読み込む。
+  ///
   Expand(const std::string& vert, const std::string& frag);
 
   ///
@@ -89,7 +123,9 @@ public:
   /// @param center サンプリングに用いるカメラの撮像面上の中心 (主点) 位置
   /// @oaram focal サンプリングに用いるカメラの主点とスクリーンの距離
   /// @param border 展開後のフレームの境界色
+  /// @param format 展開するテクスチャの画素の格納形式
   /// @param unit テクスチャユニット番号
+  /// @param flip 表示領域に直接描くために上下を反転するなら true
   /// @return 描画すべきメッシュの横と縦の格子点数
   ///
   /// @note 展開するテクスチャをマッピングするメッシュの解像度を
@@ -98,5 +134,6 @@ public:
   ///
   std::array<GLsizei, 2> setup(int samples, GLfloat aspect,  const gg::GgMatrix& pose,
     const std::array<GLfloat, 2>& fov, const std::array<GLfloat, 2>& center, GLfloat focal,
-    const std::array<GLfloat, 4>& border, int unit = 0) const;
+    const std::array<GLfloat, 4>& border,
+    FrameFormat format = FrameFormat::INTERLEAVED, int unit = 0, bool flip = false) const;
 };
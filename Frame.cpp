@@ -0,0 +1,226 @@
+﻿///
+/// キャプチャしたフレームを保持するテクスチャクラスの実装
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 19, 2026
+///
+#include "Frame.h"
+
+//
+// 画素の格納形式から色差のテクスチャの内部フォーマットを求める
+//
+static GLenum chromaInternalFormat(FrameFormat format)
+{
+  // YUYV なら U と V を２画素分並べた RGBA, NV12 なら U と V の RG
+  return format == FrameFormat::YUYV ? GL_RGBA8 : GL_RG8;
+}
+
+//
+// デストラクタ
+//
+Frame::~Frame()
+{
+  // 色差のテクスチャを破棄する
+  Frame::discard();
+}
+
+//
+// ムーブコンストラクタ
+//
+Frame::Frame(Frame&& frame) noexcept
+  : Texture{ std::move(frame) }
+  , frameFormat{ std::exchange(frame.frameFormat, FrameFormat::INTERLEAVED) }
+  , chromaSize{ std::exchange(frame.chromaSize, std::array<int, 2>{ 0, 0 }) }
+  , chromaName{ std::exchange(frame.chromaName, 0) }
+  , chromaUnit{ frame.chromaUnit }
+  , sequence{ std::exchange(frame.sequence, 0) }
+  , timestamp{ std::exchange(frame.timestamp, -1.0) }
+{
+}
+
+//
+// ムーブ代入演算子
+//
+Frame& Frame::operator=(Frame&& frame) noexcept
+{
+  // 代入元と代入先が同じでなければ
+  if (&frame != this)
+  {
+    // ムーブ元の輝度のテクスチャを引き継ぐ
+    Texture::operator=(std::move(frame));
+
+    // この色差のテクスチャを破棄して
+    Frame::discard();
+
+    // ムーブ元の色差のテクスチャと転送番号を引き継ぎ、ムーブ元は空にする
+    frameFormat = std::exchange(frame.frameFormat, FrameFormat::INTERLEAVED);
+    chromaSize = std::exchange(frame.chromaSize, std::array<int, 2>{ 0, 0 });
+    chromaName = std::exchange(frame.chromaName, 0);
+    chromaUnit = frame.chromaUnit;
+    sequence = std::exchange(frame.sequence, 0);
+    timestamp = std::exchange(frame.timestamp, -1.0);
+  }
+
+  // このフレームを返す
+  return *this;
+}
+
+//
+// フレームを格納するテクスチャを作成する
+//
+void Frame::create(GLsizei width, GLsizei height, int channels, FrameFormat format)
+{
+  // 輝度のテクスチャのチャネル数を求める
+  const auto luma{ format == FrameFormat::YUYV ? 2
+    : format == FrameFormat::NV12 ? 1 : channels };
+
+  // 指定したサイズと形式が保持しているフレームと同じなら何もしない
+  if (format == frameFormat && width == getWidth() && height == getHeight()
+    && luma == Texture::getChannels()) return;
+
+  // 輝度のテクスチャを作成する
+  Texture::create(width, height, luma);
+
+  // NV12 なら色差の平面も格納できるようにバッファを作り直す
+  if (format == FrameFormat::NV12) Buffer::create(width, height * 3 / 2, 1);
+
+  // 色差のテクスチャのサイズを求める
+  const auto size{ format == FrameFormat::YUYV ? std::array<int, 2>{ width / 2, height }
+    : format == FrameFormat::NV12 ? std::array<int, 2>{ width / 2, height / 2 }
+    : std::array<int, 2>{ 0, 0 } };
+
+  // 画素の格納形式と色差のテクスチャのサイズが同じなら何もしない
+  if (format == frameFormat && size == chromaSize) return;
+
+  // 以前の色差のテクスチャは再利用できるように戻す
+  ResourcePool::releaseTexture(chromaName, chromaSize[0], chromaSize[1], chromaInternalFormat(frameFormat));
+  chromaName = 0;
+
+  // 画素の格納形式と色差のテクスチャのサイズを記録する
+  frameFormat = format;
+  chromaSize = size;
+
+  // 画素ごとにチャネルを並べた形式なら色差のテクスチャは使わない
+  if (format == FrameFormat::INTERLEAVED) return;
+
+  // 色差のテクスチャを取り出すか新しく作る
+  chromaName = ResourcePool::acquireTexture(size[0], size[1], chromaInternalFormat(format));
+}
+
+//
+// 色差のテクスチャを破棄する
+//
+void Frame::discard()
+{
+  // 色差のテクスチャを再利用できるように戻す
+  ResourcePool::releaseTexture(chromaName, chromaSize[0], chromaSize[1], chromaInternalFormat(frameFormat));
+  chromaName = 0;
+
+  // 色差のテクスチャのサイズを 0 にする
+  chromaSize = std::array<int, 2>{ 0, 0 };
+  frameFormat = FrameFormat::INTERLEAVED;
+}
+
+//
+// テクスチャユニットを指定してテクスチャを結合する
+//
+void Frame::bindTexture(int unit) const
+{
+  // 色差のテクスチャがあれば
+  if (chromaName != 0)
+  {
+    // 次のテクスチャユニットに色差のテクスチャを結合する
+    chromaUnit = unit + 1;
+    glActiveTexture(GL_TEXTURE0 + chromaUnit);
+    glBindTexture(GL_TEXTURE_2D, chromaName);
+  }
+
+  // 輝度のテクスチャを結合する
+  Texture::bindTexture(unit);
+}
+
+//
+// テクスチャの結合を解除する
+//
+void Frame::unbindTexture() const
+{
+  // 色差のテクスチャがあれば
+  if (chromaName != 0)
+  {
+    // 色差のテクスチャの結合を解除する
+    glActiveTexture(GL_TEXTURE0 + chromaUnit);
+    glBindTexture(GL_TEXTURE_2D, 0);
+  }
+
+  // 輝度のテクスチャの結合を解除する
+  Texture::unbindTexture();
+}
+
+//
+// ピクセルバッファオブジェクトからテクスチャにデータをコピーする
+//
+void Frame::drawPixels()
+#if defined(USE_PIXEL_BUFFER_OBJECT)
+  const
+#endif
+{
+  // 画素ごとにチャネルを並べた形式ならテクスチャクラスと同じ
+  if (frameFormat == FrameFormat::INTERLEAVED)
+  {
+    Texture::drawPixels();
+    return;
+  }
+
+  // フレームのサイズ
+  const auto& size{ getSize() };
+
+  // 輝度と色差のフォーマット
+  const auto yuyv{ frameFormat == FrameFormat::YUYV };
+  const GLenum lumaFormat{ yuyv ? GL_RG : GL_RED };
+  const GLenum chromaFormat{ yuyv ? GL_RGBA : GL_RG };
+
+  // 色差のデータの先頭位置
+  const auto offset{ yuyv ? 0 : static_cast<GLsizeiptr>(size[0]) * size[1] };
+
+  // 行の境界を揃えずにデータを読み出す
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+#if defined(USE_PIXEL_BUFFER_OBJECT)
+
+  // 読み出し元のピクセルバッファオブジェクトを指定する
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, getBufferName());
+
+  // ピクセルバッファオブジェクトの輝度を輝度のテクスチャに書き込む
+  glBindTexture(GL_TEXTURE_2D, getTextureName());
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size[0], size[1],
+    lumaFormat, GL_UNSIGNED_BYTE, 0);
+
+  // ピクセルバッファオブジェクトの色差を色差のテクスチャに書き込む
+  glBindTexture(GL_TEXTURE_2D, chromaName);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, chromaSize[0], chromaSize[1],
+    chromaFormat, GL_UNSIGNED_BYTE, reinterpret_cast<const GLvoid*>(offset));
+
+  // 読み出し元のピクセルバッファオブジェクトの結合を解除する
+  glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+#else
+
+  // バッファの輝度を輝度のテクスチャに書き込む
+  glBindTexture(GL_TEXTURE_2D, getTextureName());
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size[0], size[1],
+    lumaFormat, GL_UNSIGNED_BYTE, getBufferName().data());
+
+  // バッファの色差を色差のテクスチャに書き込む
+  glBindTexture(GL_TEXTURE_2D, chromaName);
+  glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, chromaSize[0], chromaSize[1],
+    chromaFormat, GL_UNSIGNED_BYTE, getBufferName().data() + offset);
+
+#endif
+
+  // 書き込み先のテクスチャの結合を解除する
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  // 行の境界を既定値に戻す
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
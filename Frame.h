@@ -0,0 +1,222 @@
+﻿#pragma once
+
+///
+/// キャプチャしたフレームを保持するテクスチャクラスの定義
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 19, 2026
+///
+
+// テクスチャクラス
+#include "Texture.h"
+
+///
+/// キャプチャしたフレームを保持するテクスチャクラス
+///
+/// @description
+/// YUV のフレームは輝度と色差を別のテクスチャに転送し、
+/// 展開用シェーダで RGB に変換する。
+///
+class Frame : public Texture
+{
+  /// フレームの画素の格納形式
+  FrameFormat frameFormat;
+
+  /// 色差のテクスチャのサイズ
+  std::array<int, 2> chromaSize;
+
+  /// 色差のテクスチャ名
+  GLuint chromaName;
+
+  /// 色差のテクスチャを結合したテクスチャユニット
+  mutable int chromaUnit;
+
+  /// 格納しているフレームの転送番号, 不明なら 0
+  unsigned long long sequence;
+
+  /// 格納しているフレームを取得した時刻 (glfwGetTime() の時刻), 不明なら負の値
+  double timestamp;
+
+public:
+
+  ///
+  /// デフォルトコンストラクタ
+  ///
+  Frame()
+    : Texture{}
+    , frameFormat{ FrameFormat::INTERLEAVED }
+    , chromaSize{ 0, 0 }
+    , chromaName{ 0 }
+    , chromaUnit{ 1 }
+    , sequence{ 0 }
+    , timestamp{ -1.0 }
+  {
+  }
+
+  ///
+  /// コピーコンストラクタは使用しない
+  ///
+  /// @param frame コピー元
+  ///
+  Frame(const Frame& frame) = delete;
+
+  ///
+  /// ムーブコンストラクタ
+  ///
+  /// @param frame ムーブ元
+  ///
+  /// @note
+  /// ムーブ元の輝度と色差のテクスチャとピクセルバッファオブジェクトを引き継ぐ。
+  ///
+  Frame(Frame&& frame) noexcept;
+
+  ///
+  /// デストラクタ
+  ///
+  virtual ~Frame();
+
+  ///
+  /// 代入演算子は使用しない
+  ///
+  /// @param frame 代入元
+  ///
+  Frame& operator=(const Frame& frame) = delete;
+
+  ///
+  /// ムーブ代入演算子
+  ///
+  /// @param frame ムーブ代入元
+  /// @return ムーブ代入結果のフレーム
+  ///
+  Frame& operator=(Frame&& frame) noexcept;
+
+  ///
+  /// フレームを格納するテクスチャを作成する
+  ///
+  /// @param width フレームの横の画素数
+  /// @param height フレームの縦の画素数
+  /// @param channels 画素ごとにチャネルを並べた形式のときのチャネル数
+  /// @param format フレームの画素の格納形式
+  ///
+  /// @note
+  /// YUYV なら輝度を RG の２チャネル、色差を横半分の RGBA の４チャネル、
+  /// NV12 なら輝度を R の１チャネル、色差を縦横半分の RG の２チャネルのテクスチャに格納する。
+  /// サイズと形式が引数で指定したものと異なれば、テクスチャを作り直す。
+  ///
+  void create(GLsizei width, GLsizei height, int channels, FrameFormat format);
+
+  ///
+  /// フレームを格納するテクスチャを作成する
+  ///
+  /// @param width フレームの横の画素数
+  /// @param height フレームの縦の画素数
+  /// @param channels 画素ごとにチャネルを並べた形式のときのチャネル数
+  ///
+  /// @note
+  /// 画素の格納形式は変更しない。
+  ///
+  virtual void create(GLsizei width, GLsizei height, int channels)
+  {
+    create(width, height, channels, frameFormat);
+  }
+
+  ///
+  /// 色差のテクスチャを破棄する
+  ///
+  virtual void discard();
+
+  ///
+  /// フレームの画素の格納形式を得る
+  ///
+  /// @return フレームの画素の格納形式
+  ///
+  auto getFrameFormat() const
+  {
+    return frameFormat;
+  }
+
+  ///
+  /// 格納しているフレームの転送番号を得る
+  ///
+  /// @return 格納しているフレームの転送番号, 不明なら 0
+  ///
+  /// @note
+  /// 同じ転送番号のフレームの内容は同じなので、検出結果の再利用に使う。
+  ///
+  auto getSequence() const
+  {
+    return sequence;
+  }
+
+  ///
+  /// 格納しているフレームの転送番号を設定する
+  ///
+  /// @param newSequence 格納したフレームの転送番号 (Camera::getTransmittedSequence())
+  ///
+  void setSequence(unsigned long long newSequence)
+  {
+    sequence = newSequence;
+  }
+
+  ///
+  /// 格納しているフレームを取得した時刻を得る
+  ///
+  /// @return 格納しているフレームを取得した時刻 (glfwGetTime() の時刻), 不明なら負の値
+  ///
+  auto getTimestamp() const
+  {
+    return timestamp;
+  }
+
+  ///
+  /// 格納しているフレームを取得した時刻を設定する
+  ///
+  /// @param newTimestamp 格納したフレームを取得した時刻 (Camera::getTransmittedTime())
+  ///
+  void setTimestamp(double newTimestamp)
+  {
+    timestamp = newTimestamp;
+  }
+
+  ///
+  /// 展開後のフレームのチャネル数を得る
+  ///
+  /// @return YUV のフレームなら RGB に変換した後の 3
+  ///
+  virtual int getChannels() const
+  {
+    return frameFormat == FrameFormat::INTERLEAVED ? Texture::getChannels() : 3;
+  }
+
+  ///
+  /// テクスチャユニットを指定してテクスチャを結合する
+  ///
+  /// @param unit テクスチャユニット番号
+  ///
+  /// @note
+  /// 色差のテクスチャは unit + 1 のテクスチャユニットに結合する。
+  ///
+  virtual void bindTexture(int unit = 0) const;
+
+  ///
+  /// テクスチャの結合を解除する
+  ///
+  virtual void unbindTexture() const;
+
+  // テクスチャクラスのデータのコピー
+  using Texture::drawPixels;
+
+  ///
+  /// ピクセルバッファオブジェクトからテクスチャにデータをコピーする
+  ///
+  /// @note
+  /// YUV のフレームはピクセルバッファオブジェクトの中の
+  /// 輝度と色差の場所から、それぞれのテクスチャにコピーする。
+  ///
+  void drawPixels()
+#if defined(USE_PIXEL_BUFFER_OBJECT)
+    const
+#endif
+    ;
+};
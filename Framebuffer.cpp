@@ -12,8 +12,11 @@
 //
 Framebuffer::Framebuffer(GLsizei width, GLsizei height, int channels,
   GLenum attachment)
-  : attachment{ attachment }
+  : Framebuffer{}
 {
+  // カラーバッファのアタッチメントを指定して
+  this->attachment = attachment;
+
   // フレームバッファオブジェクトを作る
   Framebuffer::create(width, height, channels);
 }
@@ -24,8 +27,11 @@ Framebuffer::Framebuffer(GLsizei width, GLsizei height, int channels,
 /// @param framebuffer コピー元のフレームバッファオブジェクト
 ///
 Framebuffer::Framebuffer(const Framebuffer& framebuffer)
-  : attachment{ framebuffer.attachment }
+  : Framebuffer{}
 {
+  // コピー元と同じアタッチメントを使う
+  attachment = framebuffer.attachment;
+
   // フレームバッファオブジェクトをコピーして作成する
   Framebuffer::copy(framebuffer);
 }
@@ -36,9 +42,16 @@ Framebuffer::Framebuffer(const Framebuffer& framebuffer)
 /// @param framebuffer ムーブ元
 ///
 Framebuffer::Framebuffer(Framebuffer&& framebuffer) noexcept
+  : Texture{ std::move(framebuffer) }
+  , framebufferSize{ std::exchange(framebuffer.framebufferSize, std::array<int, 2>{ 0, 0 }) }
+  , framebufferChannels{ std::exchange(framebuffer.framebufferChannels, 0) }
+  , framebufferName{ std::exchange(framebuffer.framebufferName, 0) }
+  , attachment{ std::exchange(framebuffer.attachment, GL_COLOR_ATTACHMENT0) }
+  , revision{ std::exchange(framebuffer.revision, 0) }
+#if defined(USE_PIXEL_BUFFER_OBJECT)
+  , readbackFence{ std::exchange(framebuffer.readbackFence, nullptr) }
+#endif
 {
-  // フレームバッファイブジェクトをムーブして作成する
-  *this = std::move(framebuffer);
 }
 
 //
@@ -74,17 +87,21 @@ Framebuffer& Framebuffer::operator=(Framebuffer&& framebuffer) noexcept
   // 代入元と代入先が同じでなければ
   if (&framebuffer != this)
   {
-    // ムーブ元のフレームバッファオブジェクトをコピーする
-    Framebuffer::copy(framebuffer);
-
-    // ムーブ元のバッファを破棄する
-    framebuffer.Buffer::discard();
-
-    // ムーブ元のテクスチャを破棄する
-    framebuffer.Texture::discard();
-
-    // ムーブ元のフレームバッファオブジェクトを破棄する
-    framebuffer.Framebuffer::discard();
+    // ムーブ元のカラーバッファのテクスチャを引き継ぐ
+    Texture::operator=(std::move(framebuffer));
+
+    // このフレームバッファオブジェクトを破棄して
+    Framebuffer::discard();
+
+    // ムーブ元のフレームバッファオブジェクトを引き継ぎ、ムーブ元は空にする
+    framebufferSize = std::exchange(framebuffer.framebufferSize, std::array<int, 2>{ 0, 0 });
+    framebufferChannels = std::exchange(framebuffer.framebufferChannels, 0);
+    framebufferName = std::exchange(framebuffer.framebufferName, 0);
+    attachment = std::exchange(framebuffer.attachment, GL_COLOR_ATTACHMENT0);
+    revision = std::exchange(framebuffer.revision, 0);
+#if defined(USE_PIXEL_BUFFER_OBJECT)
+    readbackFence = std::exchange(framebuffer.readbackFence, nullptr);
+#endif
   }
 
   // このフレームバッファオブジェクトを返す
@@ -99,14 +116,20 @@ void Framebuffer::discard()
   // デフォルトのフレームバッファオブジェクトに戻す
   glBindFramebuffer(GL_FRAMEBUFFER, 0);
 
-  // フレームバッファオブジェクトを削除する
-  glDeleteFramebuffers(1, &framebufferName);
+  // フレームバッファオブジェクトを再利用できるように戻す
+  ResourcePool::releaseFramebuffer(framebufferName, attachment);
   framebufferName = 0;
 
+#if defined(USE_PIXEL_BUFFER_OBJECT)
+  // 読み出しの完了を待つフェンスも削除する
+  discardReadback();
+#endif
+
   // バッファオブジェクトのメンバを初期化する
   framebufferSize = std::array<int, 2>{ 0, 0 };
   framebufferChannels = 0;
   attachment = GL_COLOR_ATTACHMENT0;
+  revision = 0;
 }
 
 //
@@ -114,6 +137,11 @@ void Framebuffer::discard()
 //
 void Framebuffer::create(GLsizei width, GLsizei height, int channels)
 {
+#if defined(GL_GLES_PROTOTYPES)
+  // OpenGL ES では RGBA で読み出せるようにカラーバッファを常に 4 チャネルにする
+  channels = 4;
+#endif
+
   // 既存のテクスチャを破棄して新しいテクスチャを作成する
   Texture::create(width, height, channels);
 
@@ -128,11 +156,14 @@ void Framebuffer::create(GLsizei width, GLsizei height, int channels)
   framebufferSize = std::array<int, 2>{ width, height };
   framebufferChannels = channels;
 
-  // 以前のフレームバッファオブジェクトを削除する
-  glDeleteFramebuffers(1, &framebufferName);
+  // 作り直したフレームバッファオブジェクトの内容は無効
+  revision = 0;
+
+  // 以前のフレームバッファオブジェクトは再利用できるように戻す
+  ResourcePool::releaseFramebuffer(framebufferName, attachment);
 
-  // フレームバッファオブジェクトを作成する
-  glGenFramebuffers(1, &framebufferName);
+  // フレームバッファオブジェクトを取り出すか新しく作ってカラーバッファを結合する
+  framebufferName = ResourcePool::acquireFramebuffer();
   glBindFramebuffer(GL_FRAMEBUFFER, framebufferName);
   glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, getTextureName(), 0);
   glDrawBuffers(1, &attachment);
@@ -151,6 +182,9 @@ void Framebuffer::copy(const Buffer& framebuffer) noexcept
 
   // 作成したフレームバッファオブジェクトのバッファにコピーする
   copyBuffer(framebuffer);
+
+  // コピーしたのはバッファだけなので展開した内容は無効にする
+  revision = 0;
 }
 
 //
@@ -276,3 +310,66 @@ void Framebuffer::show(GLsizei width, GLsizei height) const
   glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
   glReadBuffer(GL_BACK);
 }
+
+#if defined(USE_PIXEL_BUFFER_OBJECT)
+//
+// 読み出しの完了を待つフェンスを破棄する
+//
+void Framebuffer::discardReadback()
+{
+  if (readbackFence) glDeleteSync(readbackFence);
+  readbackFence = nullptr;
+}
+
+//
+// フレームバッファオブジェクトの内容の読み出しを開始する
+//
+void Framebuffer::readPixels()
+{
+  // 前回読み出したときのフェンスは不要
+  discardReadback();
+
+  // このフレームバッファオブジェクトを読み込み元にする
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, framebufferName);
+  glReadBuffer(attachment);
+
+  // 行の境界を詰めてバッファのピクセルバッファオブジェクトに読み出す
+  // (バッファはフレームバッファオブジェクトと同じサイズとチャネル数で作られている)
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, getBufferName());
+  glPixelStorei(GL_PACK_ALIGNMENT, 1);
+  glReadPixels(0, 0, framebufferSize[0], framebufferSize[1], getFormat(), GL_UNSIGNED_BYTE, 0);
+  glPixelStorei(GL_PACK_ALIGNMENT, 4);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  // 読み込み元を通常のフレームバッファに戻す
+  glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+  glReadBuffer(GL_BACK);
+
+  // 読み出しの完了を待つフェンスを置く
+  readbackFence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+}
+
+//
+// 読み出したピクセルバッファオブジェクトをマップする
+//
+GLvoid* Framebuffer::map() const
+{
+  // 読み出しを開始していればその完了を待つ (待ちきれなくてもマップ時に同期される)
+  if (readbackFence)
+    glClientWaitSync(readbackFence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000000);
+
+  // バッファのピクセルバッファオブジェクトをマップする
+  return Buffer::map();
+}
+
+//
+// 読み出したピクセルバッファオブジェクトからテクスチャに書き戻す
+//
+void Framebuffer::drawPixels() const
+{
+  // 行の境界を詰めてバッファのピクセルバッファオブジェクトの内容をテクスチャに書き込む
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+  Texture::drawPixels(getBufferName());
+  glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+#endif
@@ -28,6 +28,19 @@ class Framebuffer : public Texture
   /// フレームバッファオブジェクトのレンダーターゲット
   GLenum attachment;
 
+  /// フレームバッファオブジェクトに展開した内容の版, 0 なら内容が無効
+  unsigned int revision;
+
+#if defined(USE_PIXEL_BUFFER_OBJECT)
+  /// バッファのピクセルバッファオブジェクトへの読み出しの完了を待つフェンス
+  GLsync readbackFence;
+
+  ///
+  /// 読み出しの完了を待つフェンスを破棄する
+  ///
+  void discardReadback();
+#endif
+
 public:
 
   ///
@@ -39,6 +52,10 @@ public:
     , framebufferChannels{ 0 }
     , framebufferName{ 0 }
     , attachment{ GL_COLOR_ATTACHMENT0 }
+    , revision{ 0 }
+#if defined(USE_PIXEL_BUFFER_OBJECT)
+    , readbackFence{ nullptr }
+#endif
   {
   }
 
@@ -65,6 +82,9 @@ public:
   ///
   /// @param framebuffer ムーブ元のフレームバッファオブジェクト
   ///
+  /// @note
+  /// ムーブ元のフレームバッファオブジェクトとカラーバッファのテクスチャを引き継ぐ。
+  ///
   Framebuffer(Framebuffer&& framebuffer) noexcept;
 
   ///
@@ -86,6 +106,10 @@ public:
   /// @param framebuffer ムーブ代入元のフレームバッファオブジェクト
   /// @return ムーブ代入結果のレームバッファオブジェクト
   ///
+  /// @note
+  /// このフレームバッファオブジェクトを破棄して、
+  /// ムーブ元のフレームバッファオブジェクトとカラーバッファのテクスチャを引き継ぐ。
+  ///
   Framebuffer& operator=(Framebuffer&& framebuffer) noexcept;
 
   ///
@@ -99,6 +123,8 @@ public:
   /// このフレームバッファオブジェクトのサイズが引数で指定したサイズと異なれば、
   /// このフレームバッファオブジェクトを削除して、
   /// 新しいフレームバッファオブジェクトを作り直す。
+  /// OpenGL ES では RGBA/UNSIGNED_BYTE の読み出しがほとんどのドライバで
+  /// 変換を伴わない経路なので、channels によらず 4 チャネルで作成する。
   ///
   virtual void create(GLsizei width, GLsizei height, int channels);
 
@@ -152,6 +178,33 @@ public:
     return framebufferChannels;
   }
 
+  ///
+  /// フレームバッファオブジェクトに展開した内容の版を得る
+  ///
+  /// @return フレームバッファオブジェクトに展開した内容の版, 0 なら内容が無効
+  ///
+  /// @note
+  /// フレームバッファオブジェクトを作り直したときは 0 になる。
+  ///
+  auto getRevision() const
+  {
+    return revision;
+  }
+
+  ///
+  /// フレームバッファオブジェクトに展開した内容の版を設定する
+  ///
+  /// @param newRevision フレームバッファオブジェクトに展開した内容の版
+  ///
+  /// @note
+  /// 展開に用いたフレームと設定が変わっていなければ、
+  /// この版を比較して展開を省略できる。
+  ///
+  void setRevision(unsigned int newRevision)
+  {
+    revision = newRevision;
+  }
+
   ///
   /// レンダリング先をフレームバッファオブジェクトに切り替える
   ///
@@ -210,4 +263,37 @@ public:
   /// @param height フレームバッファオブジェクトの内容を表示する縦の画素数
   ///
   void show(GLsizei width, GLsizei height) const;
+
+#if defined(USE_PIXEL_BUFFER_OBJECT)
+  // テクスチャのデータのコピーも使えるようにする
+  using Texture::readPixels;
+  using Texture::drawPixels;
+
+  ///
+  /// フレームバッファオブジェクトの内容の読み出しを開始する
+  ///
+  /// @note
+  /// このフレームバッファオブジェクトから glReadPixels() で
+  /// バッファのピクセルバッファオブジェクトに読み出して、完了を待つフェンスを置く。
+  /// 読み出しの完了は map() で待つので、その間に別のフレームバッファオブジェクトの
+  /// 展開や検出を行えば読み出しと重ねられる。
+  ///
+  void readPixels();
+
+  ///
+  /// 読み出したピクセルバッファオブジェクトをマップする
+  ///
+  /// @return ピクセルバッファオブジェクトをマップしたメモリ
+  ///
+  /// @note
+  /// readPixels() で開始した読み出しの完了を待ってからマップする。
+  /// マップの解除は unmap() で行う。
+  ///
+  GLvoid* map() const;
+
+  ///
+  /// バッファのピクセルバッファオブジェクトからテクスチャに書き戻す
+  ///
+  void drawPixels() const;
+#endif
 };
@@ -321,7 +321,8 @@ void GgApp::Window::wheel(GLFWwindow* window, double x, double y)
 //
 // Window クラスのコンストラクタ
 //
-GgApp::Window::Window(const std::string& title, int width, int height, int fullscreen, GLFWwindow* share) :
+GgApp::Window::Window(const std::string& title, int width, int height, int fullscreen, GLFWwindow* share,
+  bool headless) :
   window{ nullptr },
   size{ width, height },
   fboSize{ width, height },
@@ -332,6 +333,7 @@ GgApp::Window::Window(const std::string& title, int width, int height, int fulls
   velocity{ 1.0f, 1.0f, 0.1f },
   status{ false },
   interfaceNo{ 0 },
+  waitTimeout{ -1.0 },
   userPointer{ nullptr },
   resizeFunc{ nullptr },
   keyboardFunc{ nullptr },
@@ -360,9 +362,15 @@ GgApp::Window::Window(const std::string& title, int width, int height, int fulls
     height = mode->height;
   }
 
+  // ヘッドレスモードならウィンドウを表示しない
+  if (headless) glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+
   // GLFW のウィンドウを作成する
   window = glfwCreateWindow(width, height, title.c_str(), monitor, share);
 
+  // 次に作るウィンドウは表示する
+  glfwWindowHint(GLFW_VISIBLE, GLFW_TRUE);
+
   // ウィンドウが作成できなければエラー
   if (!window) throw std::runtime_error("Unable to open the GLFW window.");
 
@@ -387,8 +395,8 @@ GgApp::Window::Window(const std::string& title, int width, int height, int fulls
   // ウィンドウのサイズ変更時に呼び出す処理を登録する
   glfwSetFramebufferSizeCallback(window, resize);
 
-  // 垂直同期タイミングに合わせる
-  glfwSwapInterval(1);
+  // ヘッドレスモードでなければ垂直同期タイミングに合わせる
+  glfwSwapInterval(headless ? 0 : 1);
 
   // 実際のフレームバッファのサイズを取得する
   glfwGetFramebufferSize(window, &width, &height);
@@ -417,7 +425,10 @@ GgApp::Window::Window(const std::string& title, int width, int height, int fulls
 GgApp::Window::operator bool()
 {
   // イベントを取り出す
-  glfwPollEvents();
+  if (waitTimeout < 0.0)
+    glfwPollEvents();
+  else
+    glfwWaitEventsTimeout(waitTimeout);
 
   // ウィンドウを閉じるべきなら false を返す
   if (shouldClose()) return false;
@@ -173,6 +173,9 @@ public:
     // ヒューマンインタフェースデバイスの番号
     int interfaceNo;
 
+    // イベントを待つ最大の時間 (秒), 負ならイベントを待たない
+    double waitTimeout;
+
     //
     // ユーザー定義のコールバック関数へのポインタ
     //
@@ -212,9 +215,10 @@ public:
     /// @param height 開くウィンドウの高さ, フルスクリーン時は無視され実際のディスプレイの高さが使われる.
     /// @param fullscreen フルスクリーン表示を行うディスプレイ番号, 0 ならフルスクリーン表示を行わない.
     /// @param share 共有するコンテキスト, nullptr ならコンテキストを共有しない.
+    /// @param headless true ならウィンドウを表示せず垂直同期も待たない.
     ///
     Window(const std::string& title = "GLFW Window", int width = 640, int height = 480,
-      int fullscreen = 0, GLFWwindow* share = nullptr);
+      int fullscreen = 0, GLFWwindow* share = nullptr, bool headless = false);
 
     ///
     /// コピーコンストラクタは使用しない
@@ -269,11 +273,36 @@ public:
       return glfwWindowShouldClose(window) != GLFW_FALSE;
     }
 
+    ///
+    /// カラーバッファを入れ替えるときに待つ垂直同期の回数を設定する.
+    ///
+    /// @param interval 待つ垂直同期の回数, 0 なら垂直同期を待たない.
+    ///
+    void setSwapInterval(int interval) const
+    {
+      glfwMakeContextCurrent(window);
+      glfwSwapInterval(interval);
+    }
+
+    ///
+    /// イベントを待つ最大の時間を設定する.
+    ///
+    /// @param timeout イベントを待つ最大の時間 (秒), 負ならイベントを待たずにループを継続する.
+    ///
+    void setWaitTimeout(double timeout)
+    {
+      waitTimeout = timeout;
+    }
+
     ///
     /// イベントを取得してループを継続すべきかどうか調べる.
     ///
     /// @return ループを継続すべきなら true.
     ///
+    /// @note
+    /// setWaitTimeout() で時間を設定していれば、イベントが発生するか
+    /// その時間が経過するまで待つ.
+    ///
     explicit operator bool();
 
     ///
@@ -24,15 +24,21 @@ constexpr nfdfilteritem_t imageFilter[]{ "Images", "png,jpg,jpeg,jfif,bmp,dib" }
 // 動画ファイル名のフィルタ
 constexpr nfdfilteritem_t movieFilter[]{ "Movies", "mp4,m4v,mpg,mov,avi,ogg,mkv" };
 
+// CSV ファイル名のフィルタ
+constexpr nfdfilteritem_t csvFilter[]{ { "CSV", "csv" } };
+
 // 標準ライブラリ
 #include <iomanip>
 #include <sstream>
 #include <chrono>
+#include <cstdio>
+#include <cfloat>
+#include <algorithm>
 
 ///
 /// キャプチャデバイスを開く
 ///
-bool Menu::openDevice()
+bool Menu::openDevice(bool add)
 {
   // バックエンドが GStreamer なら
   if (backend == cv::CAP_GSTREAMER)
@@ -41,7 +47,7 @@ bool Menu::openDevice()
     const auto& pipeline{ config.deviceList.at(backend)[deviceNumber] };
 
     // ダイアログで指定したパイプラインが開けなかったら
-    if (!capture.openMovie(pipeline, backend))
+    if (!capture.openMovie(pipeline, backend, yuvOnGpu))
     {
       // 開けなかった
       errorMessage = u8"パイプラインが開けません";
@@ -56,9 +62,42 @@ bool Menu::openDevice()
   char codec[5]{};
   if (codecNumber > 0) strncpy(codec, config.codecList[codecNumber], 5);
 
+  // キャプチャデバイスを開くときに使う番号
+  const auto index{ config.getDeviceIndex(backend, deviceNumber) };
+
+  // 撮影モードを自動で選ぶなら指定した解像度で最も高いスループットが得られるものを選ぶ
+  const auto mode{ autoMode ? config.selectMode(backend, deviceNumber, intrinsics.size, intrinsics.fps) : nullptr };
+  if (mode) strncpy(codec, mode->fourcc.data(), 5);
+
+  // 同時にキャプチャするキャプチャデバイスとして追加するなら
+  if (add)
+  {
+    // 選択しているキャプチャデバイスの設定は変更しない
+    auto size{ mode ? mode->size : intrinsics.size };
+    auto fps{ mode ? mode->fps : intrinsics.fps };
+
+    // ダイアログで指定したキャプチャデバイスが追加できなかったら
+    if (!capture.addDevice(index, size, fps, backend, codec, yuvOnGpu, parallelDecode))
+    {
+      // 追加できなかった
+      errorMessage = u8"デバイスが追加できません";
+      return false;
+    }
+
+    // 追加できた
+    return true;
+  }
+
+  // 選んだ撮影モードの解像度とフレームレートで開く
+  if (mode)
+  {
+    intrinsics.size = mode->size;
+    intrinsics.fps = mode->fps;
+  }
+
   // ダイアログで指定したキャプチャデバイスが開けなかったら
-  if (!capture.openDevice(deviceNumber,
-    intrinsics.size, intrinsics.fps, backend, codec))
+  if (!capture.openDevice(index,
+    intrinsics.size, intrinsics.fps, backend, codec, yuvOnGpu, parallelDecode))
   {
     // 開けなかった
     errorMessage = u8"デバイスが開けません";
@@ -181,6 +220,13 @@ void Menu::loadConfig()
 
       // 現在の設定に反映する
       settings = config.settings;
+
+      // 読み込んだ検出の設定と ChArUco Board と辞書で検出器を作り直す
+      calibration.setDetector(settings.detector);
+      calibration.createBoard(settings.checkerLength, settings.boardSquares);
+      calibration.setBoards(settings.boards);
+      calibration.setDictionary(settings.dictionaryName, settings.checkerLength);
+      ++revision;
     }
     else
     {
@@ -265,7 +311,7 @@ void Menu::saveParameters() const
   if (NFD_SaveDialog(&filepath, jsonFilter, 1, NULL, pathString.c_str()) == NFD_OKAY)
   {
     // 現在のキャリブレーションパラメータを構成ファイルに保存する
-    if (!calibration.saveParameters(filepath))
+    if (!(rig.finished() ? rig.saveParameters(filepath) : calibration.saveParameters(filepath)))
     {
       // 保存できなかった
       errorMessage = u8"較正ファイルが保存できません";
@@ -333,32 +379,66 @@ void Menu::recordFileCorners() const
 //
 void Menu::createCharuco() const
 {
-  // ChArUco Board の画像を作成する
+  // ChArUco Board の画像をマス目の数に合わせた大きさで作成する
+  const auto& squares{ calibration.getBoardSquares() };
   cv::Mat boardImage;
-  calibration.drawBoard(boardImage, 980, 692);
+  calibration.drawBoard(boardImage, squares[0] * 98, squares[1] * 98 + 6);
 
   // ファイルに保存する
   saveImage(boardImage, "ChArUcoBoard.png");
 }
 
+//
+// 処理時間の計測結果を保存する
+//
+void Menu::saveProfile(bool trace) const
+{
+  // ファイルダイアログから得るパス
+  nfdchar_t* filepath;
+
+  // ファイルダイアログを開く
+  if (NFD_SaveDialog(&filepath, trace ? jsonFilter : csvFilter, 1, NULL,
+    trace ? "trace.json" : "profile.csv") == NFD_OKAY)
+  {
+    // 計測結果をファイルに保存する
+    if (!(trace ? profiler.saveTrace(filepath) : profiler.saveCsv(filepath)))
+    {
+      // 保存できなかった
+      errorMessage = u8"計測結果が保存できません";
+    }
+
+    // ファイルパスの取り出しに使ったメモリを開放する
+    NFD_FreePath(filepath);
+  }
+}
+
 //
 // コンストラクタ
 //
-Menu::Menu(const Config& config, Capture& capture, Calibration& calibration)
+Menu::Menu(const Config& config, Capture& capture, Calibration& calibration, Rig& rig,
+  Profiler& profiler)
   : config{ config }
   , settings{ config.settings }
   , capture{ capture }
   , calibration{ calibration }
+  , rig{ rig }
+  , profiler{ profiler }
   , deviceNumber{ 0 }
   , codecNumber{ 0 }
+  , yuvOnGpu{ false }
+  , parallelDecode{ false }
+  , autoMode{ false }
   , preferenceNumber{ 0 }
   , backend{ cv::CAP_ANY }
   , pose{ ggIdentity() }
   , menubarHeight{ 0 }
   , showInputPanel{ true }
   , showCalibrationPanel{ true }
+  , showProfilerPanel{ false }
   , quit{ false }
   , errorMessage{ nullptr }
+  , revision{ 1 }
+  , expansionRevision{ 1 }
   , detectMarker{ false }
   , detectBoard{ false }
 {
@@ -407,11 +487,48 @@ void Menu::setSize(const std::array<int, 2>& size)
 //
 // シェーダを設定する
 //
-std::array<GLsizei, 2> Menu::setup(GLfloat aspect) const
+std::array<GLsizei, 2> Menu::setup(GLfloat aspect, FrameFormat format, bool flip) const
 {
   // シェーダを設定する
   return config.preferenceList[preferenceNumber].getShader().setup(settings.samples, aspect,
-    pose, intrinsics.fov, intrinsics.center, settings.getFocal(), config.background);
+    pose, intrinsics.fov, intrinsics.center, settings.getFocal(), config.background, format, 0, flip);
+}
+
+//
+// 展開と検出に用いる設定が変更されていたら版を更新する
+//
+void Menu::updateRevision()
+{
+  // 展開に用いる設定を並べる
+  std::vector<GLfloat> state(pose.get(), pose.get() + 16);
+  state.insert(state.end(), intrinsics.fov.begin(), intrinsics.fov.end());
+  state.insert(state.end(), intrinsics.center.begin(), intrinsics.center.end());
+  state.insert(state.end(), config.background.begin(), config.background.end());
+  state.emplace_back(static_cast<GLfloat>(preferenceNumber));
+  state.emplace_back(static_cast<GLfloat>(settings.samples));
+  state.emplace_back(settings.focal);
+
+  // 展開に用いる設定の数
+  const auto expansionLength{ state.size() };
+
+  // 検出に用いる設定を並べる
+  state.insert(state.end(), settings.checkerLength.begin(), settings.checkerLength.end());
+  state.emplace_back(settings.markerLength);
+  state.emplace_back(detectMarker ? 1.0f : 0.0f);
+  state.emplace_back(detectBoard ? 1.0f : 0.0f);
+  state.emplace_back(calibration.finished() ? 1.0f : 0.0f);
+
+  // 前回と同じなら何もしない
+  if (state == lastState) return;
+
+  // 展開に用いる設定が変わっていたら展開の版も更新する
+  if (lastState.size() != state.size()
+    || !std::equal(state.begin(), state.begin() + expansionLength, lastState.begin()))
+    ++expansionRevision;
+
+  // 設定を記録して版を更新する (0 は無効な内容に使うので飛ばす)
+  lastState.swap(state);
+  if (++revision == 0) revision = 1;
 }
 
 //
@@ -468,6 +585,9 @@ void Menu::draw()
       // 較正パネルの表示
       ImGui::MenuItem(u8"較正", NULL, &showCalibrationPanel);
 
+      // 計測パネルの表示を切り替えたら計測するかどうかも切り替える
+      if (ImGui::MenuItem(u8"計測", NULL, &showProfilerPanel)) profiler.enabled = showProfilerPanel;
+
       // File メニュー修了
       ImGui::EndMenu();
     }
@@ -627,13 +747,37 @@ void Menu::draw()
       ImGui::EndCombo();
     }
 
+    // YUV のフレームを色変換せずに取り出して GPU で変換する
+    ImGui::Checkbox(u8"GPU で色変換", &yuvOnGpu);
+
+    // MJPEG のフレームをキャプチャスレッドとは別の複数のスレッドで復号する
+    ImGui::Checkbox(u8"並列に復号", &parallelDecode);
+
+    // Video for Linux なら解像度に対して最も高いスループットが得られる撮影モードを自動で選ぶ
+    if (backend == cv::CAP_V4L2)
+    {
+      ImGui::Checkbox(u8"最適な撮影モード", &autoMode);
+
+      // 選ばれる撮影モードを表示する
+      if (autoMode)
+      {
+        const auto mode{ config.selectMode(backend, deviceNumber, intrinsics.size, intrinsics.fps) };
+        if (mode) ImGui::Text("%s %dx%d %.1ffps", mode->fourcc.data(), mode->size[0], mode->size[1], mode->fps);
+        else ImGui::TextColored(ImVec4(1.0f, 0.2f, 0.0f, 1.0f), "%s", u8"撮影モードが分かりません");
+      }
+    }
+
     // キャプチャの開始と停止
     if (capture)
     {
       // キャプチャスレッドが動いているので止める
       if (ImGui::Button(u8"停止")) capture.stop();
       ImGui::SameLine();
-      ImGui::TextColored(ImVec4(0.2f, 1.0f, 0.0f, 1.0f), "%s", u8"取得中");
+
+      // 選択しているキャプチャデバイスを同時にキャプチャするキャプチャデバイスとして追加する
+      if (ImGui::Button(u8"追加") && deviceNumber >= 0 && backend != cv::CAP_GSTREAMER) openDevice(true);
+      ImGui::SameLine();
+      ImGui::TextColored(ImVec4(0.2f, 1.0f, 0.0f, 1.0f), "%s%zu", u8"取得中 ×", capture.getCount());
     }
     else
     {
@@ -674,6 +818,9 @@ void Menu::draw()
 
           // 選択した ArUco Marker の辞書を設定する
           calibration.setDictionary(settings.dictionaryName, settings.checkerLength);
+
+          // 検出をやり直す
+          ++revision;
         }
 
         // この選択を次にコンボボックスを開いたときのデフォルトにしておく
@@ -682,6 +829,98 @@ void Menu::draw()
       ImGui::EndCombo();
     }
 
+    // 検出の設定のプリセットを選択する
+    constexpr const char* presetLabel[]{ u8"高速", u8"標準", u8"高精度" };
+    const auto preset{ settings.detector.getPreset() };
+    bool detectorChanged{ false };
+    if (ImGui::BeginCombo(u8"検出設定", preset < 0 ? u8"カスタム" : presetLabel[preset]))
+    {
+      // すべてのプリセットについて
+      for (int i = 0; i < static_cast<int>(DetectorSettings::presetList.size()); ++i)
+      {
+        // プリセットを（それを選択していればハイライトして）コンボボックスに表示する
+        if (ImGui::Selectable(presetLabel[i], i == preset))
+        {
+          // 選択したプリセットの設定にする
+          settings.detector.setPreset(i);
+          detectorChanged = true;
+
+          // この選択を次にコンボボックスを開いたときのデフォルトにしておく
+          ImGui::SetItemDefaultFocus();
+        }
+      }
+      ImGui::EndCombo();
+    }
+
+    // 検出の設定の個々の項目
+    if (ImGui::TreeNode(u8"検出の詳細"))
+    {
+      // 適応的二値化の窓の大きさの最小値・最大値・増分
+      auto& winSize{ settings.detector.adaptiveThreshWinSize };
+      if (ImGui::InputInt3(u8"二値化窓", winSize.data()))
+      {
+        // 窓の大きさは３以上、増分は１以上にする
+        winSize[0] = std::max(winSize[0], 3);
+        winSize[1] = std::max(winSize[1], winSize[0]);
+        winSize[2] = std::max(winSize[2], 1);
+        detectorChanged = true;
+      }
+
+      // コーナーの位置の補正方法
+      constexpr const char* refinementLabel[]{ u8"なし", u8"サブピクセル", u8"輪郭", u8"AprilTag" };
+      detectorChanged |= ImGui::Combo(u8"コーナー補正", &settings.detector.cornerRefinementMethod,
+        refinementLabel, IM_ARRAYSIZE(refinementLabel));
+
+      // ChArUco Board のコーナーをサブピクセル精度で補正する窓の大きさの半分
+      if (ImGui::SliderInt(u8"サブピクセル窓", &settings.detector.subPixelWindow, 0, 15,
+        settings.detector.subPixelWindow > 0 ? "%d" : u8"なし"))
+        detectorChanged = true;
+
+      // ChArUco Board のコーナーのサブピクセル精度の補正の最大の繰り返し回数
+      if (settings.detector.subPixelWindow > 0
+        && ImGui::InputInt(u8"補正回数", &settings.detector.subPixelIterations))
+      {
+        settings.detector.subPixelIterations = std::max(settings.detector.subPixelIterations, 1);
+        detectorChanged = true;
+      }
+
+      // マーカの候補の周長の最小の比率
+      if (ImGui::InputFloat(u8"最小周長比", &settings.detector.minMarkerPerimeterRate,
+        0.01f, 0.05f, "%.3f"))
+      {
+        settings.detector.minMarkerPerimeterRate = std::max(settings.detector.minMarkerPerimeterRate, 0.0f);
+        detectorChanged = true;
+      }
+
+      // ArUco3 の高速な検出
+      detectorChanged |= ImGui::Checkbox(u8"ArUco3 検出", &settings.detector.useAruco3Detection);
+
+      // ArUco3 で縮小した画像上のマーカの一辺の最小の長さ
+      if (ImGui::SliderInt(u8"最小辺長", &settings.detector.minSideLengthCanonicalImg, 1, 128))
+      {
+        // 0 だと縮小率が求められないので１以上にする
+        settings.detector.minSideLengthCanonicalImg = std::max(settings.detector.minSideLengthCanonicalImg, 1);
+        detectorChanged = true;
+      }
+
+      // ArUco3 で前のフレームからマーカが縮小する割合の見込み
+      detectorChanged |= ImGui::SliderFloat(u8"動きの速さ", &settings.detector.cameraMotionSpeed,
+        0.0f, 1.0f, "%.2f");
+
+      // ArUco3 で現在検出に用いているマーカの最小の大きさ
+      if (settings.detector.useAruco3Detection)
+        ImGui::Text(u8"最小マーカ長比: %.4f", calibration.getMarkerLengthRatio());
+
+      ImGui::TreePop();
+    }
+
+    // 検出の設定が変更されたら検出器を作り直す
+    if (detectorChanged)
+    {
+      calibration.setDetector(settings.detector);
+      ++revision;
+    }
+
     ImGui::Separator();
 
     // ArUco Marker の検出
@@ -702,6 +941,22 @@ void Menu::draw()
       calibration.createBoard(settings.checkerLength);
     }
 
+    // ChArUco Board のマス目の数
+    if (ImGui::InputInt2(u8"升目数", settings.boardSquares.data()))
+    {
+      // マス目は縦横とも３以上にする
+      for (auto& n : settings.boardSquares) n = std::max(n, 3);
+
+      // ChArUco Board を作り直す
+      calibration.createBoard(settings.checkerLength, settings.boardSquares);
+      ++revision;
+    }
+
+    // 同時に検出する追加の較正板の検出状況
+    if (calibration.getExtraBoardCount() > 0)
+      ImGui::Text(u8"追加ボード検出数: %d / %zu", calibration.getDetectedExtraBoardCount(),
+        calibration.getExtraBoardCount());
+
     // 「取得」ボタンをクリックしたとき ChArUco Board の検出中なら
     if (ImGui::Button(u8"取得") && detectBoard)
     {
@@ -737,8 +992,73 @@ void Menu::draw()
       }
     }
 
+    // 複数のカメラから同時にキャプチャしていれば
+    if (rig.getCount() > 1)
+    {
+      ImGui::Separator();
+
+      // 「同時取得」ボタンをクリックしたとき ChArUco Board の検出中なら
+      if (ImGui::Button(u8"同時取得") && detectBoard)
+      {
+        // すべてのカメラで検出したコーナーを記録する
+        rig.recordCorners();
+      }
+
+      // 同時に検出した標本を１つでも取得していれば
+      if (rig.getSampleCount() > 0)
+      {
+        // 同時に検出した標本と外部較正の結果の「同時消去」ボタンを表示する
+        ImGui::SameLine();
+        if (ImGui::Button(u8"同時消去")) rig.discardCorners();
+      }
+
+      // 同時に検出した標本を３つ以上取得していれば
+      if (rig.getSampleCount() >= 3)
+      {
+        // 「外部較正」ボタンを表示する
+        ImGui::SameLine();
+        if (ImGui::Button(u8"外部較正") && !rig.calibrate())
+        {
+          // 較正失敗
+          errorMessage = u8"外部較正に失敗しました";
+        }
+      }
+
+      // 同時に検出した標本数の表示
+      ImGui::Text(u8"同時サンプル取得数: %d", rig.getSampleCount());
+
+      // 較正が完了していれば追加したカメラごとの再投影誤差を表示する
+      if (rig.finished())
+      {
+        for (size_t i = 1; i < rig.getCount(); ++i)
+        {
+          ImGui::Text(u8"カメラ %zu の再投影誤差: %.4f", i, rig.getReprojectionError(i));
+        }
+      }
+    }
+
     ImGui::Separator();
 
+    // フレームの表示方式を選択する
+    const auto presentation{ static_cast<int>(settings.presentation) };
+    if (ImGui::BeginCombo(u8"表示方式", config.presentationList[presentation]))
+    {
+      // すべての表示方式について
+      for (int i = 0; i < static_cast<int>(config.presentationList.size()); ++i)
+      {
+        // 表示方式を（それを選択していればハイライトして）コンボボックスに表示する
+        if (ImGui::Selectable(config.presentationList[i], i == presentation))
+        {
+          // 選択した表示方式に切り替える
+          settings.presentation = static_cast<Presentation>(i);
+
+          // この選択を次にコンボボックスを開いたときのデフォルトにしておく
+          ImGui::SetItemDefaultFocus();
+        }
+      }
+      ImGui::EndCombo();
+    }
+
     // フレームレートの表示
     ImGui::Text(u8"フレームレート: %6.2f fps", ImGui::GetIO().Framerate);
 
@@ -754,6 +1074,81 @@ void Menu::draw()
     ImGui::End();
   }
 
+  // 計測パネル
+  if (showProfilerPanel)
+  {
+    // ウィンドウの位置とサイズ
+    ImGui::SetNextWindowPos(ImVec2(459.0f, 2.0f + menubarHeight), ImGuiCond_Once);
+    ImGui::SetNextWindowSize(ImVec2(320, 480), ImGuiCond_Once);
+    ImGui::Begin(u8"計測", &showProfilerPanel);
+
+    // 計測結果を保存する
+    if (ImGui::Button(u8"CSV 保存")) saveProfile(false);
+    ImGui::SameLine();
+    if (ImGui::Button(u8"トレース保存")) saveProfile(true);
+    ImGui::SameLine();
+
+    // 計測結果を破棄する
+    if (ImGui::Button(u8"消去")) profiler.clear();
+
+    // 転送しなかったフレームの数
+    ImGui::Text(u8"取りこぼし: %llu", capture.getDroppedFrames());
+
+    // GPU の資源の使用中と再利用のために保持している数とメモリ量
+    static constexpr const char* kindName[]{ u8"バッファ", u8"テクスチャ", u8"FBO" };
+    for (int i = 0; i < 3; ++i)
+    {
+      const auto kind{ static_cast<ResourcePool::Kind>(i) };
+      const auto& live{ ResourcePool::getLiveUsage(kind) };
+      const auto& pooled{ ResourcePool::getPooledUsage(kind) };
+      ImGui::Text(u8"%s: %zu 個 %.1f MB (保持 %zu 個 %.1f MB)", kindName[i],
+        live.count, live.bytes / 1048576.0, pooled.count, pooled.bytes / 1048576.0);
+    }
+
+    // フレームを取得してからの遅延の百分位数
+    if (profiler.getLatencyCount() > 0) ImGui::TextUnformatted(u8"遅延 (p50 / p95 / p99)");
+    for (size_t i = 0; i < profiler.getLatencyCount(); ++i)
+    {
+      const auto percentiles{ profiler.getLatencyPercentiles(i) };
+      ImGui::Text("%s: %.1f / %.1f / %.1f ms", profiler.getLatencyName(i).c_str(),
+        percentiles[0], percentiles[1], percentiles[2]);
+    }
+
+    // すべての計測区間について
+    for (size_t i = 0; i < profiler.getStageCount(); ++i)
+    {
+      ImGui::Separator();
+
+      // 計測区間の名前
+      const auto& name{ profiler.getName(i) };
+      ImGui::TextUnformatted(name.c_str());
+
+      // 履歴のグラフに重ねて表示する平均値
+      char average[32];
+
+      // CPU の経過時間の履歴
+      const auto& cpu{ profiler.getCpuHistory(i) };
+      std::snprintf(average, sizeof average, "CPU %.3f ms", profiler.getAverage(cpu));
+      ImGui::PlotHistogram(("##cpu" + name).c_str(), cpu.data(), Profiler::historyLength,
+        profiler.getHead(), average, 0.0f, FLT_MAX, ImVec2(0.0f, 40.0f));
+
+      // GPU の経過時間も計測していれば
+      if (profiler.hasGpuTime(i))
+      {
+        // GPU の経過時間の履歴
+        const auto& gpu{ profiler.getGpuHistory(i) };
+        std::snprintf(average, sizeof average, "GPU %.3f ms", profiler.getAverage(gpu));
+        ImGui::PlotHistogram(("##gpu" + name).c_str(), gpu.data(), Profiler::historyLength,
+          profiler.getHead(), average, 0.0f, FLT_MAX, ImVec2(0.0f, 40.0f));
+      }
+    }
+
+    ImGui::End();
+
+    // 計測パネルを閉じたら計測をやめる
+    if (!showProfilerPanel) profiler.enabled = false;
+  }
+
   // エラーメッセージが設定されていたら
   if (errorMessage)
   {
@@ -786,6 +1181,9 @@ void Menu::draw()
     calibration.recordCorners();
   }
 
+  // 展開と検出に用いる設定が変更されていたら版を更新する
+  updateRevision();
+
   // ImGui のフレームに描画する
   ImGui::Render();
 }
@@ -17,6 +17,12 @@
 // 較正オブジェクト
 #include "Calibration.h"
 
+// 複数のカメラの較正オブジェクト
+#include "Rig.h"
+
+// 処理時間の計測
+#include "Profiler.h"
+
 ///
 /// メニューの描画
 ///
@@ -37,12 +43,27 @@ class Menu
   /// 較正オブジェクト
   Calibration& calibration;
 
+  /// 複数のカメラの較正オブジェクト
+  Rig& rig;
+
+  /// 処理時間の計測オブジェクト
+  Profiler& profiler;
+
   /// 選択しているキャプチャデバイスの番号
   int deviceNumber;
 
   /// 選択しているコーデックの番号
   int codecNumber;
 
+  /// YUV のフレームを GPU で色変換するなら true
+  bool yuvOnGpu;
+
+  /// MJPEG のフレームを複数のスレッドで復号するなら true
+  bool parallelDecode;
+
+  /// キャプチャデバイスを開くときに最も高いスループットが得られる撮影モードを選ぶなら true
+  bool autoMode;
+
   /// 使用中の構成の番号
   int preferenceNumber;
 
@@ -61,16 +82,36 @@ class Menu
   /// 較正パネルの表示
   bool showCalibrationPanel;
 
+  /// 計測パネルの表示
+  bool showProfilerPanel;
+
   /// 終了するなら true
   bool quit;
 
   /// エラーが無ければ nullptr
   mutable const char* errorMessage;
 
+  /// 展開と検出に用いる設定の版
+  unsigned int revision;
+
+  /// 展開に用いる設定の版
+  unsigned int expansionRevision;
+
+  /// 前回調べたときの展開と検出に用いる設定
+  std::vector<GLfloat> lastState;
+
+  ///
+  /// 展開と検出に用いる設定が変更されていたら版を更新する
+  ///
+  void updateRevision();
+
   ///
   /// キャプチャデバイスを開く
   ///
-  bool openDevice();
+  /// @param add 同時にキャプチャするキャプチャデバイスとして追加するなら true
+  /// @return 開くことができたら true
+  ///
+  bool openDevice(bool add = false);
 
   ///
   /// 画像ファイルを開く
@@ -100,6 +141,9 @@ class Menu
   ///
   /// 較正ファイルを保存する
   ///
+  /// @note
+  /// 複数のカメラの較正が完了していれば、追加したカメラの姿勢も保存する。
+  ///
   void saveParameters() const;
 
   ///
@@ -112,6 +156,13 @@ class Menu
   ///
   void createCharuco() const;
 
+  ///
+  /// 処理時間の計測結果を保存する
+  ///
+  /// @param trace Chrome のトレース形式で保存するなら true、CSV 形式で保存するなら false
+  ///
+  void saveProfile(bool trace) const;
+
   ///
   /// 指定した番号の構成を調べる
   ///
@@ -144,8 +195,11 @@ public:
   /// @param config 構成データ
   /// @param capture 入力フレームを取得するキャプチャデバイス
   /// @param calibration 較正オブジェクト
+  /// @param rig 複数のカメラの較正オブジェクト
+  /// @param profiler 処理時間の計測オブジェクト
   ///
-  Menu(const Config& config, Capture& capture, Calibration& calibration);
+  Menu(const Config& config, Capture& capture, Calibration& calibration, Rig& rig,
+    Profiler& profiler);
 
   ///
   /// コピーコンストラクタは使用しない
@@ -228,16 +282,52 @@ public:
     return settings.markerLength;
   }
 
+  ///
+  /// フレームの表示方式を得る
+  ///
+  /// @return フレームの表示方式
+  ///
+  auto getPresentation() const
+  {
+    return settings.presentation;
+  }
+
+  ///
+  /// 展開と検出に用いる設定の版を得る
+  ///
+  /// @return 展開と検出に用いる設定の版, 設定が変更されるたびに変わる (0 にはならない)
+  ///
+  auto getRevision() const
+  {
+    return revision;
+  }
+
+  ///
+  /// 展開に用いる設定の版を得る
+  ///
+  /// @return 展開に用いる設定の版, 展開結果が変わる設定が変更されるたびに変わる
+  ///
+  /// @note
+  /// フレームの転送番号とこの版が同じなら展開した画像は同じなので、検出結果を再利用できる。
+  ///
+  auto getExpansionRevision() const
+  {
+    return expansionRevision;
+  }
+
   ///
   /// シェーダを設定する
   ///
   /// @param aspect 表示領域の縦横比
+  /// @param format 展開するフレームの画素の格納形式
+  /// @param flip 表示領域に直接描くために上下を反転するなら true
   /// @return 描画すべきメッシュの横と縦の格子点数
   ///
   /// @note
   /// 格子点数は画角 aspect と展開用メッシュのサンプル点数 samples から求める。
   ///
-  std::array<GLsizei, 2> setup(GLfloat aspect) const;
+  std::array<GLsizei, 2> setup(GLfloat aspect,
+    FrameFormat format = FrameFormat::INTERLEAVED, bool flip = false) const;
 
   ///
   /// メニューを描画する
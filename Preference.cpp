@@ -25,7 +25,7 @@ Preference::Preference(const std::string& description,
   : description{ description }
   , source{ vert, frag }
   , intrinsics{ intrinsics }
-  , shader{ nullptr }
+  , key{ vert + "\t" + frag }
 {
 }
 
@@ -35,13 +35,15 @@ Preference::Preference(const std::string& description,
 //
 Preference::Preference(const picojson::object& object)
   : intrinsics{ object }
-  , shader{ nullptr }
 {
   // 説明の文字列
   getString(object, "description", description);
 
   // 展開用シェーダのファイル名
   getString(object, "shader", source);
+
+  // ソースファイル名をつないでシェーダを検索するキーを作る
+  key = source[0] + "\t" + source[1];
 }
 
 //
@@ -56,13 +58,14 @@ Preference::~Preference()
 //
 // シェーダをビルドする
 //
-void Preference::buildShader()
+const Expand& Preference::buildShader() const
 {
-  // ソースファイル名をつないでシェーダを検索するキーを作る
-  const auto key{ source[0] + "\t" + source[1] };
+  // キーがシェーダリストにあればそのシェーダを返す
+  const auto shader{ shaderList.find(key) };
+  if (shader != shaderList.end()) return shader->second;
 
   // キーがシェーダリストに無ければシェーダを構築して追加する
-  shader = &shaderList.try_emplace(key, source[0], source[1]).first->second;
+  return shaderList.try_emplace(key, source[0], source[1]).first->second;
 }
 
 //
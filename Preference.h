@@ -28,8 +28,8 @@ class Preference
   /// キャプチャデバイス固有のパラメータ
   const Intrinsics intrinsics;
 
-  /// この構成の展開用シェーダへのポインタ
-  const Expand* shader;
+  /// この構成の展開用シェーダをシェーダリストから検索するキー
+  std::string key;
 
   /// すべての構成の展開用シェーダのリスト
   static std::map<std::string, Expand> shaderList;
@@ -70,7 +70,12 @@ public:
   ///
   /// シェーダをビルドする
   ///
-  void buildShader();
+  /// @return この構成の展開用シェーダの参照
+  ///
+  /// @note
+  /// 同じソースファイルの組み合わせのシェーダがすでにビルドされていればそれを返す。
+  ///
+  const Expand& buildShader() const;
 
   ///
   /// 説明を取り出す
@@ -97,9 +102,12 @@ public:
   ///
   /// @return この構成のシェーダの参照
   ///
+  /// @note
+  /// シェーダはこの構成を最初に使うときにビルドする。
+  ///
   const auto& getShader() const
   {
-    return *shader;
+    return buildShader();
   }
 
   ///
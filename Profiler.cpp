@@ -0,0 +1,358 @@
+﻿///
+/// 処理時間の計測クラスの実装
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 19, 2026
+///
+#include "Profiler.h"
+
+// 構成ファイルの読み取り補助
+#include "parseconfig.h"
+
+// 標準ライブラリ
+#include <algorithm>
+#include <fstream>
+
+//
+// コンストラクタ
+//
+Profiler::Profiler()
+  : origin{ Clock::now() }
+  , head{ 0 }
+  , frameCount{ 0 }
+  , querying{ false }
+  , enabled{ false }
+{
+}
+
+//
+// デストラクタ
+//
+Profiler::~Profiler()
+{
+#if !defined(GL_GLES_PROTOTYPES)
+  // 結果を待っているクエリも再利用するクエリに戻す
+  for (auto& stage : stages)
+  {
+    for (const auto& query : stage.pending) queries.emplace_back(query.first);
+  }
+
+  // クエリを削除する
+  if (!queries.empty()) glDeleteQueries(static_cast<GLsizei>(queries.size()), queries.data());
+#endif
+}
+
+//
+// 計測区間の番号を得る
+//
+size_t Profiler::getStage(const char* name, bool gpu)
+{
+  // 同じ名前の計測区間があればその番号を返す
+  for (size_t i = 0; i < stages.size(); ++i)
+  {
+    if (stages[i].name == name) return i;
+  }
+
+  // 計測区間を追加する
+  stages.emplace_back(name, gpu);
+  return stages.size() - 1;
+}
+
+//
+// 結果が得られた GPU の計測結果を集計する
+//
+void Profiler::resolve()
+{
+#if !defined(GL_GLES_PROTOTYPES)
+  // すべての計測区間について
+  for (size_t i = 0; i < stages.size(); ++i)
+  {
+    auto& stage{ stages[i] };
+
+    // 結果を待っているクエリについて
+    while (!stage.pending.empty())
+    {
+      // 最も古いクエリの結果がまだ得られていなければ次の計測区間に移る
+      const auto& query{ stage.pending.front() };
+      GLint available{ GL_FALSE };
+      glGetQueryObjectiv(query.first, GL_QUERY_RESULT_AVAILABLE, &available);
+      if (available == GL_FALSE) break;
+
+      // GPU の経過時間を取り出す
+      GLuint64 time{ 0 };
+      glGetQueryObjectui64v(query.first, GL_QUERY_RESULT, &time);
+
+      // ナノ秒単位の経過時間を現在のフレームに加える
+      stage.gpuTime += static_cast<double>(time) * 1.0e-6;
+
+      // 計測結果を記録する
+      events.push_back({ i, query.second, static_cast<double>(time) * 1.0e-3, true });
+
+      // クエリを再利用する
+      queries.emplace_back(query.first);
+      stage.pending.pop_front();
+    }
+  }
+#endif
+}
+
+//
+// フレームの計測を終えて履歴に追加する
+//
+void Profiler::nextFrame()
+{
+  // 結果が得られた GPU の計測結果を集計する
+  resolve();
+
+  // すべての計測区間について
+  for (auto& stage : stages)
+  {
+    // 現在のフレームの経過時間を履歴に追加する
+    stage.cpuHistory[head] = static_cast<float>(stage.cpuTime);
+    stage.gpuHistory[head] = static_cast<float>(stage.gpuTime);
+
+    // 次のフレームの計測を始める
+    stage.cpuTime = stage.gpuTime = 0.0;
+  }
+
+  // 履歴の書き込み位置を進める
+  head = (head + 1) % historyLength;
+  ++frameCount;
+
+  // 計測結果の記録が多すぎたら古いものを捨てる
+  while (events.size() > eventLimit) events.pop_front();
+}
+
+//
+// 計測結果を破棄する
+//
+void Profiler::clear()
+{
+  // 結果を待っているクエリがあれば集計を済ませる
+  resolve();
+
+  // 履歴を消去する
+  for (auto& stage : stages)
+  {
+    stage.cpuHistory.fill(0.0f);
+    stage.gpuHistory.fill(0.0f);
+    stage.cpuTime = stage.gpuTime = 0.0;
+  }
+  events.clear();
+  head = 0;
+  frameCount = 0;
+
+  // 記録した遅延を消去する
+  for (auto& latency : latencies)
+  {
+    latency.samples.clear();
+    latency.next = 0;
+  }
+}
+
+//
+// 履歴の平均を求める
+//
+float Profiler::getAverage(const std::array<float, historyLength>& history) const
+{
+  // 記録したフレーム数
+  const auto count{ std::min<unsigned long long>(frameCount, historyLength) };
+  if (count == 0) return 0.0f;
+
+  // 記録したフレームの経過時間の合計を求める
+  float sum{ 0.0f };
+  for (unsigned long long i = 1; i <= count; ++i)
+    sum += history[(head + historyLength - i) % historyLength];
+
+  // 平均を返す
+  return sum / count;
+}
+
+//
+// 計測結果を CSV ファイルに保存する
+//
+bool Profiler::saveCsv(const std::string& filename) const
+{
+  // 保存先のファイルを開く
+  std::ofstream file{ filename };
+  if (!file) return false;
+
+  // 見出しを書き出す
+  file << "frame";
+  for (size_t i = 0; i < stages.size(); ++i)
+  {
+    file << ',' << stages[i].name << " cpu";
+    if (hasGpuTime(i)) file << ',' << stages[i].name << " gpu";
+  }
+  file << '\n';
+
+  // 履歴に残っているフレームについて古い順に
+  const auto count{ std::min<unsigned long long>(frameCount, historyLength) };
+  for (auto n = frameCount - count; n < frameCount; ++n)
+  {
+    // 履歴の位置
+    const auto h{ n % historyLength };
+
+    // 計測区間ごとの経過時間を書き出す
+    file << n;
+    for (size_t i = 0; i < stages.size(); ++i)
+    {
+      file << ',' << stages[i].cpuHistory[h];
+      if (hasGpuTime(i)) file << ',' << stages[i].gpuHistory[h];
+    }
+    file << '\n';
+  }
+
+  // 書き込みに成功したか調べる
+  return static_cast<bool>(file);
+}
+
+//
+// 計測結果を Chrome のトレース形式の JSON ファイルに保存する
+//
+bool Profiler::saveTrace(const std::string& filename) const
+{
+  // 保存先のファイルを開く
+  std::ofstream file{ filename };
+  if (!file) return false;
+
+  // 計測結果の配列
+  picojson::array traceEvents;
+
+  // すべての計測結果について
+  for (const auto& event : events)
+  {
+    // 完了したイベントとして格納する
+    picojson::object object;
+    setString(object, "name", stages[event.stage].name);
+    setString(object, "cat", event.gpu ? "gpu" : "cpu");
+    setString(object, "ph", "X");
+    setValue(object, "ts", event.start);
+    setValue(object, "dur", event.duration);
+    setValue(object, "pid", 0);
+    setValue(object, "tid", event.gpu ? 1 : 0);
+    traceEvents.emplace_back(object);
+  }
+
+  // 計測結果の配列を格納する
+  picojson::object trace;
+  trace.emplace("traceEvents", traceEvents);
+  setString(trace, "displayTimeUnit", "ms");
+
+  // シリアライズして保存する
+  file << picojson::value{ trace }.serialize();
+
+  // 書き込みに成功したか調べる
+  return static_cast<bool>(file);
+}
+
+//
+// フレームを取得してからの遅延を記録する
+//
+void Profiler::addLatency(const char* name, double latency)
+{
+  // 同じ名前の処理を探してなければ追加する
+  auto found{ std::find_if(latencies.begin(), latencies.end(),
+    [name](const Latency& l) { return l.name == name; }) };
+  if (found == latencies.end()) found = latencies.emplace(latencies.end(), name);
+
+  // 保持する数に達するまでは追加し、達したら古いものから置き換える
+  const auto sample{ static_cast<float>(latency * 1000.0) };
+  if (found->samples.size() < latencyLength) found->samples.emplace_back(sample);
+  else found->samples[found->next] = sample;
+  found->next = (found->next + 1) % latencyLength;
+}
+
+//
+// 遅延の百分位数を求める
+//
+std::array<float, 3> Profiler::getLatencyPercentiles(size_t latency) const
+{
+  // 記録した遅延を並べ替えるために複製する
+  auto samples{ latencies[latency].samples };
+  if (samples.empty()) return { 0.0f, 0.0f, 0.0f };
+
+  // 指定した割合の位置の値を求める
+  std::array<float, 3> result;
+  constexpr double ratio[]{ 0.50, 0.95, 0.99 };
+  for (size_t i = 0; i < result.size(); ++i)
+  {
+    const auto n{ static_cast<size_t>(ratio[i] * (samples.size() - 1) + 0.5) };
+    std::nth_element(samples.begin(), samples.begin() + n, samples.end());
+    result[i] = samples[n];
+  }
+
+  return result;
+}
+
+//
+// 区間の処理時間の計測を開始する
+//
+Profiler::Scope::Scope(Profiler& profiler, const char* name, bool gpu)
+  : profiler{ profiler }
+  , stage{ static_cast<size_t>(-1) }
+  , query{ 0 }
+{
+  // 計測しないなら何もしない
+  if (!profiler.enabled) return;
+
+  // 計測区間の番号を得る
+  stage = profiler.getStage(name, gpu);
+
+#if !defined(GL_GLES_PROTOTYPES)
+  // GPU の経過時間を計測するとき計測中の区間がなければ
+  if (gpu && !profiler.querying)
+  {
+    // 再利用するクエリがなければ新しく作る
+    if (profiler.queries.empty())
+    {
+      GLuint newQuery;
+      glGenQueries(1, &newQuery);
+      profiler.queries.emplace_back(newQuery);
+    }
+
+    // 再利用するクエリを取り出して計測を開始する
+    query = profiler.queries.back();
+    profiler.queries.pop_back();
+    glBeginQuery(GL_TIME_ELAPSED, query);
+    profiler.querying = true;
+  }
+#endif
+
+  // 計測を開始した時刻
+  start = Clock::now();
+}
+
+//
+// 区間の処理時間の計測を終了する
+//
+Profiler::Scope::~Scope()
+{
+  // 計測を開始していなければ何もしない
+  if (stage >= profiler.stages.size()) return;
+
+  // 計測を終了した時刻
+  const auto end{ Clock::now() };
+
+  // 計測区間
+  auto& s{ profiler.stages[stage] };
+
+  // CPU の経過時間を現在のフレームに加える
+  s.cpuTime += std::chrono::duration<double, std::milli>(end - start).count();
+
+  // 計測結果を記録する
+  const auto begin{ profiler.elapsed(start) };
+  profiler.events.push_back({ stage, begin, profiler.elapsed(end) - begin, false });
+
+#if !defined(GL_GLES_PROTOTYPES)
+  // GPU の経過時間を計測していたら
+  if (query != 0)
+  {
+    // 計測を終了して結果を待つ
+    glEndQuery(GL_TIME_ELAPSED);
+    s.pending.emplace_back(query, begin);
+    profiler.querying = false;
+  }
+#endif
+}
@@ -0,0 +1,422 @@
+﻿#pragma once
+
+///
+/// 処理時間の計測クラスの定義
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 19, 2026
+///
+
+// 補助プログラム
+#include "gg.h"
+using namespace gg;
+
+// 標準ライブラリ
+#include <array>
+#include <chrono>
+#include <deque>
+#include <string>
+#include <vector>
+
+///
+/// 処理時間の計測クラス
+///
+/// @description
+/// メインループの処理の区間ごとに CPU の経過時間を std::chrono::steady_clock で、
+/// GPU の経過時間を GL_TIME_ELAPSED のクエリで計測し、フレームごとの履歴を保持する。
+/// GPU の計測結果はクエリの結果が得られた時点 (通常は数フレーム後) に集計する。
+/// OpenGL ES には GL_TIME_ELAPSED がないので CPU の経過時間だけを計測する。
+/// また、フレームを取得してから各処理を終えるまでの遅延を記録して百分位数を求める。
+///
+class Profiler
+{
+public:
+
+  /// 履歴に保持するフレーム数
+  static constexpr int historyLength{ 240 };
+
+  /// 百分位数を求めるために保持する遅延の数
+  static constexpr size_t latencyLength{ 1000 };
+
+private:
+
+  /// 時刻
+  using Clock = std::chrono::steady_clock;
+
+  ///
+  /// 計測区間
+  ///
+  struct Stage
+  {
+    /// 計測区間の名前
+    const std::string name;
+
+    /// GPU の経過時間も計測するなら true
+    const bool gpu;
+
+    /// 現在のフレームで計測した CPU の経過時間の合計 (ミリ秒)
+    double cpuTime;
+
+    /// 現在のフレームで結果が得られた GPU の経過時間の合計 (ミリ秒)
+    double gpuTime;
+
+    /// フレームごとの CPU の経過時間の履歴
+    std::array<float, historyLength> cpuHistory;
+
+    /// フレームごとの GPU の経過時間の履歴
+    std::array<float, historyLength> gpuHistory;
+
+    /// 結果を待っているクエリと計測を開始した時刻
+    std::deque<std::pair<GLuint, double>> pending;
+
+    ///
+    /// コンストラクタ
+    ///
+    /// @param name 計測区間の名前
+    /// @param gpu GPU の経過時間も計測するなら true
+    ///
+    Stage(const char* name, bool gpu)
+      : name{ name }
+      , gpu{ gpu }
+      , cpuTime{ 0.0 }
+      , gpuTime{ 0.0 }
+      , cpuHistory{}
+      , gpuHistory{}
+    {
+    }
+  };
+
+  ///
+  /// Chrome のトレース形式で書き出す計測結果
+  ///
+  struct Event
+  {
+    /// 計測区間の番号
+    size_t stage;
+
+    /// 計測を開始した時刻 (マイクロ秒)
+    double start;
+
+    /// 経過時間 (マイクロ秒)
+    double duration;
+
+    /// GPU の経過時間なら true
+    bool gpu;
+  };
+
+  ///
+  /// フレームを取得してからの遅延
+  ///
+  struct Latency
+  {
+    /// 遅延を計測する処理の名前
+    const std::string name;
+
+    /// 記録した遅延 (ミリ秒)
+    std::vector<float> samples;
+
+    /// 次に記録する位置
+    size_t next;
+
+    ///
+    /// コンストラクタ
+    ///
+    /// @param name 遅延を計測する処理の名前
+    ///
+    Latency(const char* name)
+      : name{ name }
+      , next{ 0 }
+    {
+    }
+  };
+
+  /// 計測区間
+  std::vector<Stage> stages;
+
+  /// フレームを取得してからの遅延
+  std::vector<Latency> latencies;
+
+  /// 再利用するクエリ
+  std::vector<GLuint> queries;
+
+  /// 計測結果の記録
+  std::deque<Event> events;
+
+  /// 記録する計測結果の最大数
+  static constexpr size_t eventLimit{ 100000 };
+
+  /// 計測の基準時刻
+  const Clock::time_point origin;
+
+  /// 履歴の次の書き込み位置
+  int head;
+
+  /// 計測したフレーム数
+  unsigned long long frameCount;
+
+  /// GPU の経過時間を計測中なら true
+  bool querying;
+
+  ///
+  /// 計測区間の番号を得る
+  ///
+  /// @param name 計測区間の名前
+  /// @param gpu GPU の経過時間も計測するなら true
+  /// @return 計測区間の番号
+  ///
+  /// @note
+  /// 同じ名前の計測区間がなければ新しく追加する。
+  ///
+  size_t getStage(const char* name, bool gpu);
+
+  ///
+  /// 基準時刻からの経過時間を求める
+  ///
+  /// @param time 時刻
+  /// @return 基準時刻からの経過時間 (マイクロ秒)
+  ///
+  double elapsed(Clock::time_point time) const
+  {
+    return std::chrono::duration<double, std::micro>(time - origin).count();
+  }
+
+  ///
+  /// 結果が得られた GPU の計測結果を集計する
+  ///
+  void resolve();
+
+public:
+
+  ///
+  /// 区間の処理時間の計測
+  ///
+  /// @description
+  /// このオブジェクトの生存期間を一つの計測区間として処理時間を計測する。
+  /// GPU の経過時間の計測は入れ子にできないので、
+  /// 計測中の区間があれば内側の区間の GPU の経過時間は計測しない。
+  ///
+  class Scope
+  {
+    /// 計測結果を記録する処理時間の計測オブジェクト
+    Profiler& profiler;
+
+    /// 計測区間の番号
+    size_t stage;
+
+    /// 計測を開始した時刻
+    Clock::time_point start;
+
+    /// GPU の経過時間を計測しているクエリ
+    GLuint query;
+
+  public:
+
+    ///
+    /// コンストラクタ
+    ///
+    /// @param profiler 計測結果を記録する処理時間の計測オブジェクト
+    /// @param name 計測区間の名前
+    /// @param gpu GPU の経過時間も計測するなら true
+    ///
+    Scope(Profiler& profiler, const char* name, bool gpu = false);
+
+    ///
+    /// コピーコンストラクタは使用しない
+    ///
+    /// @param scope コピー元
+    ///
+    Scope(const Scope& scope) = delete;
+
+    ///
+    /// デストラクタ
+    ///
+    virtual ~Scope();
+
+    ///
+    /// 代入演算子は使用しない
+    ///
+    /// @param scope 代入元
+    ///
+    Scope& operator=(const Scope& scope) = delete;
+  };
+
+  /// 計測するなら true
+  bool enabled;
+
+  ///
+  /// コンストラクタ
+  ///
+  Profiler();
+
+  ///
+  /// コピーコンストラクタは使用しない
+  ///
+  /// @param profiler コピー元
+  ///
+  Profiler(const Profiler& profiler) = delete;
+
+  ///
+  /// デストラクタ
+  ///
+  virtual ~Profiler();
+
+  ///
+  /// 代入演算子は使用しない
+  ///
+  /// @param profiler 代入元
+  ///
+  Profiler& operator=(const Profiler& profiler) = delete;
+
+  ///
+  /// フレームの計測を終えて履歴に追加する
+  ///
+  /// @note
+  /// メインループの一回の繰り返しごとに呼び出す。
+  ///
+  void nextFrame();
+
+  ///
+  /// 計測結果を破棄する
+  ///
+  void clear();
+
+  ///
+  /// 計測区間の数を得る
+  ///
+  /// @return 計測区間の数
+  ///
+  auto getStageCount() const
+  {
+    return stages.size();
+  }
+
+  ///
+  /// 計測区間の名前を得る
+  ///
+  /// @param stage 計測区間の番号
+  /// @return 計測区間の名前
+  ///
+  const auto& getName(size_t stage) const
+  {
+    return stages[stage].name;
+  }
+
+  ///
+  /// 計測区間で GPU の経過時間も計測しているか調べる
+  ///
+  /// @param stage 計測区間の番号
+  /// @return GPU の経過時間も計測していれば true
+  ///
+  bool hasGpuTime(size_t stage) const
+  {
+#if defined(GL_GLES_PROTOTYPES)
+    return false;
+#else
+    return stages[stage].gpu;
+#endif
+  }
+
+  ///
+  /// 計測区間の CPU の経過時間の履歴を得る
+  ///
+  /// @param stage 計測区間の番号
+  /// @return フレームごとの CPU の経過時間 (ミリ秒) の履歴
+  ///
+  const auto& getCpuHistory(size_t stage) const
+  {
+    return stages[stage].cpuHistory;
+  }
+
+  ///
+  /// 計測区間の GPU の経過時間の履歴を得る
+  ///
+  /// @param stage 計測区間の番号
+  /// @return フレームごとの GPU の経過時間 (ミリ秒) の履歴
+  ///
+  const auto& getGpuHistory(size_t stage) const
+  {
+    return stages[stage].gpuHistory;
+  }
+
+  ///
+  /// 履歴のもっとも古いフレームの位置を得る
+  ///
+  /// @return 履歴のもっとも古いフレームの位置
+  ///
+  auto getHead() const
+  {
+    return head;
+  }
+
+  ///
+  /// 履歴の平均を求める
+  ///
+  /// @param history フレームごとの経過時間の履歴
+  /// @return 記録したフレームの経過時間の平均 (ミリ秒)
+  ///
+  float getAverage(const std::array<float, historyLength>& history) const;
+
+  ///
+  /// 計測結果を CSV ファイルに保存する
+  ///
+  /// @param filename 保存するファイル名
+  /// @return 保存に成功したら true
+  ///
+  /// @note
+  /// 履歴に残っているフレームごとに計測区間の CPU と GPU の経過時間を書き出す。
+  ///
+  bool saveCsv(const std::string& filename) const;
+
+  ///
+  /// 計測結果を Chrome のトレース形式の JSON ファイルに保存する
+  ///
+  /// @param filename 保存するファイル名
+  /// @return 保存に成功したら true
+  ///
+  /// @note
+  /// chrome://tracing や Perfetto で読み込める。
+  /// CPU の計測結果はスレッド 0、GPU の計測結果はスレッド 1 に置く。
+  ///
+  bool saveTrace(const std::string& filename) const;
+
+  ///
+  /// フレームを取得してからの遅延を記録する
+  ///
+  /// @param name 遅延を計測する処理の名前
+  /// @param latency フレームを取得してからその処理を終えるまでの時間 (秒)
+  ///
+  /// @note
+  /// ヘッドレスモードで処理区間を計測しなくても百分位数を報告できるように enabled にかかわらず記録する。
+  ///
+  void addLatency(const char* name, double latency);
+
+  ///
+  /// 遅延を計測している処理の数を得る
+  ///
+  /// @return 遅延を計測している処理の数
+  ///
+  auto getLatencyCount() const
+  {
+    return latencies.size();
+  }
+
+  ///
+  /// 遅延を計測している処理の名前を得る
+  ///
+  /// @param latency 遅延を計測している処理の番号
+  /// @return 遅延を計測している処理の名前
+  ///
+  const auto& getLatencyName(size_t latency) const
+  {
+    return latencies[latency].name;
+  }
+
+  ///
+  /// 遅延の百分位数を求める
+  ///
+  /// @param latency 遅延を計測している処理の番号
+  /// @return 記録している遅延の 50, 95, 99 パーセンタイル (ミリ秒)
+  ///
+  std::array<float, 3> getLatencyPercentiles(size_t latency) const;
+};
@@ -0,0 +1,273 @@
+﻿///
+/// GPU の資源の再利用クラスの実装
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 19, 2026
+///
+#include "ResourcePool.h"
+
+//
+// 内部フォーマットから glTexImage2D() に指定するフォーマットを求める
+//
+static GLenum internalToFormat(GLenum internal)
+{
+  switch (internal)
+  {
+  case GL_R8:
+    return GL_RED;
+  case GL_RG8:
+    return GL_RG;
+  case GL_RGB8:
+    return GL_RGB;
+  default:
+    return GL_RGBA;
+  }
+}
+
+//
+// 内部フォーマットから一画素のバイト数を求める
+//
+static size_t internalToBytes(GLenum internal)
+{
+  switch (internal)
+  {
+  case GL_R8:
+    return 1;
+  case GL_RG8:
+    return 2;
+  case GL_RGB8:
+    return 3;
+  default:
+    return 4;
+  }
+}
+
+//
+// 保持している資源を取り出す
+//
+GLuint ResourcePool::take(Kind kind, GLsizeiptr width, GLsizei height, GLenum format, size_t bytes)
+{
+  // 同じキーの資源を最近使ったものから探す
+  for (auto entry{ entries.rbegin() }; entry != entries.rend(); ++entry)
+  {
+    if (entry->kind == kind && entry->width == width && entry->height == height && entry->format == format)
+    {
+      // 見つかればそれを取り出して使用中にする
+      const auto name{ entry->name };
+      auto& p{ pooled[static_cast<int>(kind)] };
+      --p.count;
+      p.bytes -= entry->bytes;
+      entries.erase(std::next(entry).base());
+
+      auto& l{ live[static_cast<int>(kind)] };
+      ++l.count;
+      l.bytes += bytes;
+      return name;
+    }
+  }
+
+  // 保持していなかったので呼び出し側で作る資源を使用中として数える
+  auto& l{ live[static_cast<int>(kind)] };
+  ++l.count;
+  l.bytes += bytes;
+  return 0;
+}
+
+//
+// 使い終わった資源を保持する
+//
+void ResourcePool::keep(const Entry& entry)
+{
+  // 使用中から外して
+  auto& l{ live[static_cast<int>(entry.kind)] };
+  if (l.count > 0) --l.count;
+  l.bytes -= std::min(l.bytes, entry.bytes);
+
+  // 最近使ったものとして保持する
+  entries.push_back(entry);
+  auto& p{ pooled[static_cast<int>(entry.kind)] };
+  ++p.count;
+  p.bytes += entry.bytes;
+
+  // 上限を超えていたら長く使われていないものから削除する
+  evict();
+}
+
+//
+// 資源を削除する
+//
+void ResourcePool::destroy(const Entry& entry)
+{
+  switch (entry.kind)
+  {
+  case Kind::BUFFER:
+    glDeleteBuffers(1, &entry.name);
+    break;
+  case Kind::TEXTURE:
+    glDeleteTextures(1, &entry.name);
+    break;
+  case Kind::FRAMEBUFFER:
+    glDeleteFramebuffers(1, &entry.name);
+    break;
+  }
+}
+
+//
+// 保持している資源が上限を超えていたら長く使われていないものから削除する
+//
+void ResourcePool::evict()
+{
+  // 保持している資源のメモリ量の合計を求める
+  size_t bytes{ 0 };
+  for (const auto& p : pooled) bytes += p.bytes;
+
+  // 上限を超えている間
+  while (!entries.empty() && (bytes > budget || entries.size() > limit))
+  {
+    // 最も長く使われていない資源を削除する
+    const auto& entry{ entries.front() };
+    destroy(entry);
+    auto& p{ pooled[static_cast<int>(entry.kind)] };
+    --p.count;
+    p.bytes -= entry.bytes;
+    bytes -= entry.bytes;
+    entries.pop_front();
+  }
+}
+
+//
+// ピクセルバッファオブジェクトを取り出す
+//
+GLuint ResourcePool::acquireBuffer(GLsizeiptr length)
+{
+  // 大きさのないピクセルバッファオブジェクトは作らない
+  if (length <= 0) return 0;
+
+  // 同じデータ長のものを保持していればそれを返す
+  const auto bytes{ static_cast<size_t>(length) };
+  if (const auto name{ take(Kind::BUFFER, length, 0, 0, bytes) }) return name;
+
+  // なければ新しいピクセルバッファオブジェクトを作成してメモリを確保する
+  GLuint name;
+  glGenBuffers(1, &name);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, name);
+  glBufferData(GL_PIXEL_PACK_BUFFER, length, nullptr, GL_DYNAMIC_COPY);
+  glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+  return name;
+}
+
+//
+// 使い終わったピクセルバッファオブジェクトを戻す
+//
+void ResourcePool::releaseBuffer(GLuint name, GLsizeiptr length)
+{
+  if (name != 0) keep({ Kind::BUFFER, length, 0, 0, name, static_cast<size_t>(length) });
+}
+
+//
+// テクスチャを取り出す
+//
+GLuint ResourcePool::acquireTexture(GLsizei width, GLsizei height, GLenum internal)
+{
+  // 大きさのないテクスチャは作らない
+  if (width <= 0 || height <= 0) return 0;
+
+  // 同じサイズと内部フォーマットのものを保持していればそれを返す
+  const auto bytes{ static_cast<size_t>(width) * height * internalToBytes(internal) };
+  if (const auto name{ take(Kind::TEXTURE, width, height, internal, bytes) }) return name;
+
+  // なければ新しいテクスチャを作成する
+  GLuint name;
+  glGenTextures(1, &name);
+  glBindTexture(GL_TEXTURE_2D, name);
+
+  // 変更できないテクスチャのメモリを確保する
+#if defined(GL_GLES_PROTOTYPES)
+  glTexStorage2D(GL_TEXTURE_2D, 1, internal, width, height);
+#else
+#  if !defined(__APPLE__)
+  if (glTexStorage2D)
+    glTexStorage2D(GL_TEXTURE_2D, 1, internal, width, height);
+  else
+#  endif
+    // glTexStorage2D() が使えなければ同じ内部フォーマットで確保する
+    glTexImage2D(GL_TEXTURE_2D, 0, internal, width, height, 0,
+      internalToFormat(internal), GL_UNSIGNED_BYTE, nullptr);
+#endif
+
+  // ミップマップは使わない
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+  glBindTexture(GL_TEXTURE_2D, 0);
+
+  return name;
+}
+
+//
+// 使い終わったテクスチャを戻す
+//
+void ResourcePool::releaseTexture(GLuint name, GLsizei width, GLsizei height, GLenum internal)
+{
+  if (name != 0) keep({ Kind::TEXTURE, width, height, internal, name,
+    static_cast<size_t>(width) * height * internalToBytes(internal) });
+}
+
+//
+// フレームバッファオブジェクトを取り出す
+//
+GLuint ResourcePool::acquireFramebuffer()
+{
+  // 保持していればそれを返す
+  if (const auto name{ take(Kind::FRAMEBUFFER, 0, 0, 0, 0) }) return name;
+
+  // なければ新しいフレームバッファオブジェクトを作成する
+  GLuint name;
+  glGenFramebuffers(1, &name);
+
+  return name;
+}
+
+//
+// 使い終わったフレームバッファオブジェクトを戻す
+//
+void ResourcePool::releaseFramebuffer(GLuint name, GLenum attachment)
+{
+  // フレームバッファオブジェクトがなければ何もしない
+  if (name == 0) return;
+
+  // 結合しているテクスチャが削除されても解放されるように切り離す
+  GLint current;
+  glGetIntegerv(GL_FRAMEBUFFER_BINDING, &current);
+  glBindFramebuffer(GL_FRAMEBUFFER, name);
+  glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, 0, 0);
+  glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(current) == name ? 0 : current);
+
+  keep({ Kind::FRAMEBUFFER, 0, 0, 0, name, 0 });
+}
+
+//
+// 保持している資源をすべて削除する
+//
+void ResourcePool::clear()
+{
+  for (const auto& entry : entries) destroy(entry);
+  entries.clear();
+  pooled.fill(Usage{ 0, 0 });
+}
+
+// 保持している資源
+std::list<ResourcePool::Entry> ResourcePool::entries;
+
+// 使用中の資源の種類ごとの使用量
+std::array<ResourcePool::Usage, 3> ResourcePool::live{};
+
+// 保持している資源の種類ごとの使用量
+std::array<ResourcePool::Usage, 3> ResourcePool::pooled{};
+
+// 保持する資源のメモリ量の上限 (256MB)
+size_t ResourcePool::budget{ 256 << 20 };
@@ -0,0 +1,248 @@
+﻿#pragma once
+
+///
+/// GPU の資源の再利用クラスの定義
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 19, 2026
+///
+
+// 補助プログラム
+#include "gg.h"
+
+// 標準ライブラリ
+#include <array>
+#include <list>
+
+///
+/// GPU の資源の再利用クラス
+///
+/// @description
+/// 使い終わったピクセルバッファオブジェクト、テクスチャ、フレームバッファオブジェクトを
+/// 種類とサイズとフォーマットをキーにして保持しておき、同じキーの資源が必要になったときに
+/// 再利用する。キャプチャデバイスや構成を切り替えてフレームのサイズが変わるたびに
+/// 作り直す代わりに以前の資源をここに戻すので、元のサイズに戻したときは作り直さずに済む。
+/// 保持している資源のメモリ量が上限を超えたら最も長く使われていないものから削除する。
+/// 使用中の資源と保持している資源の数とメモリ量を種類ごとに数える。
+///
+class ResourcePool
+{
+public:
+
+  ///
+  /// 資源の種類
+  ///
+  enum class Kind : int
+  {
+    /// ピクセルバッファオブジェクト
+    BUFFER = 0,
+
+    /// テクスチャ
+    TEXTURE = 1,
+
+    /// フレームバッファオブジェクト
+    FRAMEBUFFER = 2
+  };
+
+  ///
+  /// 資源の使用量
+  ///
+  struct Usage
+  {
+    /// 資源の数
+    size_t count;
+
+    /// 資源のメモリ量の概算 (バイト)
+    size_t bytes;
+  };
+
+private:
+
+  ///
+  /// 保持している資源
+  ///
+  struct Entry
+  {
+    /// 資源の種類
+    Kind kind;
+
+    /// テクスチャの横の画素数, ピクセルバッファオブジェクトならデータ長
+    GLsizeiptr width;
+
+    /// テクスチャの縦の画素数
+    GLsizei height;
+
+    /// テクスチャの内部フォーマット
+    GLenum format;
+
+    /// 資源の名前
+    GLuint name;
+
+    /// 資源のメモリ量の概算 (バイト)
+    size_t bytes;
+  };
+
+  /// 保持している資源, 前ほど長く使われていないもの
+  static std::list<Entry> entries;
+
+  /// 使用中の資源の種類ごとの使用量
+  static std::array<Usage, 3> live;
+
+  /// 保持している資源の種類ごとの使用量
+  static std::array<Usage, 3> pooled;
+
+  /// 保持する資源のメモリ量の上限 (バイト)
+  static size_t budget;
+
+  /// 保持する資源の数の上限
+  static constexpr size_t limit{ 32 };
+
+  ///
+  /// 保持している資源を取り出す
+  ///
+  /// @param kind 資源の種類
+  /// @param width テクスチャの横の画素数, ピクセルバッファオブジェクトならデータ長
+  /// @param height テクスチャの縦の画素数
+  /// @param format テクスチャの内部フォーマット
+  /// @param bytes 資源のメモリ量の概算
+  /// @return 取り出した資源の名前, 保持していなければ 0
+  ///
+  static GLuint take(Kind kind, GLsizeiptr width, GLsizei height, GLenum format, size_t bytes);
+
+  ///
+  /// 使い終わった資源を保持する
+  ///
+  /// @param entry 保持する資源
+  ///
+  static void keep(const Entry& entry);
+
+  ///
+  /// 資源を削除する
+  ///
+  /// @param entry 削除する資源
+  ///
+  static void destroy(const Entry& entry);
+
+  ///
+  /// 保持している資源が上限を超えていたら長く使われていないものから削除する
+  ///
+  static void evict();
+
+public:
+
+  ///
+  /// ピクセルバッファオブジェクトを取り出す
+  ///
+  /// @param length ピクセルバッファオブジェクトのデータ長
+  /// @return ピクセルバッファオブジェクト名
+  ///
+  /// @note
+  /// 同じデータ長のものを保持していればそれを返し、なければ新しく作る。
+  ///
+  static GLuint acquireBuffer(GLsizeiptr length);
+
+  ///
+  /// 使い終わったピクセルバッファオブジェクトを戻す
+  ///
+  /// @param name ピクセルバッファオブジェクト名, 0 なら何もしない
+  /// @param length ピクセルバッファオブジェクトのデータ長
+  ///
+  static void releaseBuffer(GLuint name, GLsizeiptr length);
+
+  ///
+  /// テクスチャを取り出す
+  ///
+  /// @param width テクスチャの横の画素数
+  /// @param height テクスチャの縦の画素数
+  /// @param internal テクスチャの内部フォーマット
+  /// @return テクスチャ名
+  ///
+  /// @note
+  /// 同じサイズと内部フォーマットのものを保持していればそれを返し、なければ新しく作る。
+  ///
+  static GLuint acquireTexture(GLsizei width, GLsizei height, GLenum internal);
+
+  ///
+  /// 使い終わったテクスチャを戻す
+  ///
+  /// @param name テクスチャ名, 0 なら何もしない
+  /// @param width テクスチャの横の画素数
+  /// @param height テクスチャの縦の画素数
+  /// @param internal テクスチャの内部フォーマット
+  ///
+  static void releaseTexture(GLuint name, GLsizei width, GLsizei height, GLenum internal);
+
+  ///
+  /// フレームバッファオブジェクトを取り出す
+  ///
+  /// @return フレームバッファオブジェクト名
+  ///
+  /// @note
+  /// フレームバッファオブジェクトはメモリを持たないので、保持していれば何でも返す。
+  /// カラーバッファは呼び出し側で結合する。
+  ///
+  static GLuint acquireFramebuffer();
+
+  ///
+  /// 使い終わったフレームバッファオブジェクトを戻す
+  ///
+  /// @param name フレームバッファオブジェクト名, 0 なら何もしない
+  /// @param attachment 結合しているカラーバッファのアタッチメント
+  ///
+  /// @note
+  /// 結合しているテクスチャは切り離す。
+  ///
+  static void releaseFramebuffer(GLuint name, GLenum attachment = GL_COLOR_ATTACHMENT0);
+
+  ///
+  /// 保持する資源のメモリ量の上限を設定する
+  ///
+  /// @param bytes 保持する資源のメモリ量の上限 (バイト)
+  ///
+  static void setBudget(size_t bytes)
+  {
+    budget = bytes;
+    evict();
+  }
+
+  ///
+  /// 保持する資源のメモリ量の上限を得る
+  ///
+  /// @return 保持する資源のメモリ量の上限 (バイト)
+  ///
+  static auto getBudget()
+  {
+    return budget;
+  }
+
+  ///
+  /// 使用中の資源の使用量を得る
+  ///
+  /// @param kind 資源の種類
+  /// @return 使用中の資源の数とメモリ量の概算
+  ///
+  static const auto& getLiveUsage(Kind kind)
+  {
+    return live[static_cast<int>(kind)];
+  }
+
+  ///
+  /// 保持している資源の使用量を得る
+  ///
+  /// @param kind 資源の種類
+  /// @return 保持している資源の数とメモリ量の概算
+  ///
+  static const auto& getPooledUsage(Kind kind)
+  {
+    return pooled[static_cast<int>(kind)];
+  }
+
+  ///
+  /// 保持している資源をすべて削除する
+  ///
+  /// @note
+  /// OpenGL のコンテキストを破棄する前に呼び出す。
+  ///
+  static void clear();
+};
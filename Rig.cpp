@@ -0,0 +1,256 @@
+﻿///
+/// 複数のカメラの較正クラスの実装
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 19, 2026
+///
+#include "Rig.h"
+
+// OpenCV
+#include <opencv2/calib3d.hpp>
+
+// 標準ライブラリ
+#include <algorithm>
+#include <fstream>
+
+//
+// コンストラクタ
+//
+Rig::Rig(Calibration& primary)
+  : primary{ primary }
+{
+}
+
+//
+// デストラクタ
+//
+Rig::~Rig()
+{
+}
+
+//
+// カメラの数を設定する
+//
+void Rig::resize(size_t count)
+{
+  // 追加したカメラの数
+  const auto n{ count > 0 ? count - 1 : 0 };
+
+  // 追加したカメラの数が変わっていたら
+  if (n != others.size())
+  {
+    // 追加したカメラの較正オブジェクトの数を合わせる
+    while (others.size() < n) others.emplace_back();
+    while (others.size() > n) others.pop_back();
+
+    // 記録した標本と較正結果を破棄する
+    allObjectPoints.assign(n, {});
+    allPrimaryPoints.assign(n, {});
+    allImagePoints.assign(n, {});
+    rotations.assign(n, cv::Mat{});
+    translations.assign(n, cv::Mat{});
+    errors.assign(n, 0.0);
+  }
+
+  // 追加したカメラでも選択しているカメラと同じ ChArUco Board を使う
+  for (auto& other : others) other.shareBoard(primary);
+}
+
+//
+// 同時に検出した ChArUco Board のコーナーを標本として記録する
+//
+void Rig::recordCorners()
+{
+  // 個々のカメラの内部パラメータの較正用の標本を記録する
+  for (size_t i = 0; i < getCount(); ++i) get(i).recordCorners();
+
+  // ChArUco Board 上のコーナーの位置
+  const auto& chessboard{ primary.getBoard()->getChessboardCorners() };
+
+  // 選択しているカメラで検出したコーナー
+  const auto& primaryCorners{ primary.getCharucoCorners() };
+  const auto& primaryIds{ primary.getCharucoIds() };
+
+  // 追加したカメラについて
+  for (size_t i = 0; i < others.size(); ++i)
+  {
+    // 追加したカメラで検出したコーナー
+    const auto& corners{ others[i].getCharucoCorners() };
+    const auto& ids{ others[i].getCharucoIds() };
+
+    // 両方のカメラで検出したコーナー
+    std::vector<cv::Point3f> objectPoints;
+    std::vector<cv::Point2f> primaryPoints, imagePoints;
+
+    // 選択しているカメラで検出したコーナーについて
+    for (size_t j = 0; j < primaryIds.size(); ++j)
+    {
+      // 同じコーナーを追加したカメラでも検出していれば
+      const auto k{ std::find(ids.begin(), ids.end(), primaryIds[j]) };
+      if (k == ids.end()) continue;
+
+      // ChArUco Board 上の点と対応するそれぞれの画像上の点を記録する
+      objectPoints.emplace_back(chessboard[primaryIds[j]]);
+      primaryPoints.emplace_back(primaryCorners[j]);
+      imagePoints.emplace_back(corners[k - ids.begin()]);
+    }
+
+    // 両方のカメラで６つ以上のコーナーを検出していれば標本にする
+    if (objectPoints.size() >= 6)
+    {
+      allObjectPoints[i].emplace_back(std::move(objectPoints));
+      allPrimaryPoints[i].emplace_back(std::move(primaryPoints));
+      allImagePoints[i].emplace_back(std::move(imagePoints));
+    }
+  }
+}
+
+//
+// 記録した標本と較正結果を破棄する
+//
+void Rig::discardCorners()
+{
+  // 個々のカメラの標本と較正結果を破棄する
+  for (size_t i = 0; i < getCount(); ++i) get(i).discardCorners();
+
+  // 同時に検出した標本と較正結果を破棄する
+  for (size_t i = 0; i < others.size(); ++i)
+  {
+    allObjectPoints[i].clear();
+    allPrimaryPoints[i].clear();
+    allImagePoints[i].clear();
+    rotations[i].release();
+    translations[i].release();
+    errors[i] = 0.0;
+  }
+}
+
+//
+// カメラの相対的な姿勢を較正する
+//
+bool Rig::calibrate()
+{
+  // 内部パラメータが求められていないカメラがあれば
+  for (size_t i = 0; i < getCount(); ++i)
+  {
+    // 先に内部パラメータを較正する
+    auto& calibration{ get(i) };
+    if (!calibration.finished() && !(calibration.calibrate() && calibration.finished())) return false;
+  }
+
+  // 選択しているカメラの内部パラメータ
+  cv::Mat primaryMatrix{ primary.getCameraMatrix().clone() };
+  cv::Mat primaryDist{ primary.getDistortionCoefficients().clone() };
+
+  // 追加したカメラについて
+  for (size_t i = 0; i < others.size(); ++i)
+  {
+    // 同時に検出した標本が３つ未満なら較正しない
+    if (allObjectPoints[i].size() < 3) return false;
+
+    // 追加したカメラの内部パラメータ
+    cv::Mat cameraMatrix{ others[i].getCameraMatrix().clone() };
+    cv::Mat distCoeffs{ others[i].getDistortionCoefficients().clone() };
+
+    try
+    {
+      // 内部パラメータを固定して選択しているカメラに対する姿勢を求める
+      cv::Mat essential, fundamental;
+      errors[i] = cv::stereoCalibrate(allObjectPoints[i], allPrimaryPoints[i], allImagePoints[i],
+        primaryMatrix, primaryDist, cameraMatrix, distCoeffs, primary.getImageSize(),
+        rotations[i], translations[i], essential, fundamental, cv::CALIB_FIX_INTRINSIC);
+    }
+    catch (const cv::Exception&)
+    {
+      // 較正に失敗した場合は計算結果を捨てる
+      rotations[i].release();
+      translations[i].release();
+      errors[i] = 0.0;
+
+      // 較正に失敗したことを報告する
+      return false;
+    }
+  }
+
+  // 較正に成功したことを報告する
+  return true;
+}
+
+//
+// 同時に検出した標本の数を得る
+//
+int Rig::getSampleCount() const
+{
+  // 追加したカメラがなければ 0
+  if (allObjectPoints.empty()) return 0;
+
+  // 追加したカメラごとの標本の数の最小値を返す
+  size_t count{ allObjectPoints.front().size() };
+  for (const auto& objectPoints : allObjectPoints) count = std::min(count, objectPoints.size());
+  return static_cast<int>(count);
+}
+
+//
+// 較正が完了したかどうかを調べる
+//
+bool Rig::finished() const
+{
+  // 追加したカメラがなければ完了しない
+  if (others.empty()) return false;
+
+  // すべての追加したカメラの姿勢が求められているか調べる
+  for (size_t i = 0; i < others.size(); ++i)
+  {
+    if (rotations[i].total() != 9 || translations[i].total() != 3) return false;
+  }
+  return true;
+}
+
+//
+// キャリブレーションパラメータをファイルに保存する
+//
+bool Rig::saveParameters(const std::string& filename) const
+{
+  // 設定値を保存する
+  std::ofstream config{ filename };
+  if (!config) return false;
+
+  // オブジェクト
+  picojson::object object;
+
+  // 選択しているカメラのキャリブレーションパラメータを格納する
+  primary.storeParameters(object);
+
+  // 追加したカメラのパラメータの配列
+  picojson::array cameras;
+
+  // 追加したカメラについて
+  for (size_t i = 0; i < others.size(); ++i)
+  {
+    // 追加したカメラのキャリブレーションパラメータを格納する
+    picojson::object camera;
+    others[i].storeParameters(camera);
+
+    // 選択しているカメラに対する姿勢
+    Calibration::setMatrix(camera, "rotation", rotations[i]);
+    Calibration::setMatrix(camera, "translation", translations[i]);
+
+    // 姿勢の再投影誤差
+    setValue(camera, "stereo error", errors[i]);
+
+    // 配列に追加する
+    cameras.emplace_back(camera);
+  }
+
+  // 追加したカメラのパラメータの配列を格納する
+  object.emplace("cameras", cameras);
+
+  // 構成をシリアライズして保存
+  picojson::value v{ object };
+  config << v.serialize(true);
+  config.close();
+
+  // キャリブレーションパラメータの書き込み
+  return true;
+}
@@ -0,0 +1,170 @@
+﻿#pragma once
+
+///
+/// 複数のカメラの較正クラスの定義
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 19, 2026
+///
+
+// 較正
+#include "Calibration.h"
+
+// 標準ライブラリ
+#include <deque>
+
+///
+/// 複数のカメラの較正クラス
+///
+/// @description
+/// 同時にキャプチャした複数のカメラのフレームから ChArUco Board を検出し、
+/// 選択しているカメラ (番号 0) に対する他のカメラの相対的な姿勢を求める。
+/// 個々のカメラの内部パラメータはそれぞれの較正オブジェクトで求める。
+///
+class Rig
+{
+  /// 選択しているカメラの較正オブジェクト
+  Calibration& primary;
+
+  /// 追加したカメラの較正オブジェクト
+  std::deque<Calibration> others;
+
+  /// 追加したカメラごとの同時に検出した ChArUco Board 上の点
+  std::vector<std::vector<std::vector<cv::Point3f>>> allObjectPoints;
+
+  /// 追加したカメラごとの同時に検出した選択しているカメラの画像上の点
+  std::vector<std::vector<std::vector<cv::Point2f>>> allPrimaryPoints;
+
+  /// 追加したカメラごとの同時に検出した追加したカメラの画像上の点
+  std::vector<std::vector<std::vector<cv::Point2f>>> allImagePoints;
+
+  /// 追加したカメラごとの選択しているカメラに対する回転行列
+  std::vector<cv::Mat> rotations;
+
+  /// 追加したカメラごとの選択しているカメラに対する並進ベクトル
+  std::vector<cv::Mat> translations;
+
+  /// 追加したカメラごとの再投影誤差
+  std::vector<double> errors;
+
+public:
+
+  ///
+  /// コンストラクタ
+  ///
+  /// @param primary 選択しているカメラの較正オブジェクト
+  ///
+  Rig(Calibration& primary);
+
+  ///
+  /// コピーコンストラクタは使用しない
+  ///
+  /// @param rig コピー元
+  ///
+  Rig(const Rig& rig) = delete;
+
+  ///
+  /// デストラクタ
+  ///
+  virtual ~Rig();
+
+  ///
+  /// 代入演算子は使用しない
+  ///
+  /// @param rig 代入元
+  ///
+  Rig& operator=(const Rig& rig) = delete;
+
+  ///
+  /// カメラの数を設定する
+  ///
+  /// @param count 同時にキャプチャしているカメラの数
+  ///
+  /// @note
+  /// カメラの数が変わったら記録した標本と較正結果を破棄する。
+  /// 追加したカメラの較正オブジェクトは選択しているカメラの ChArUco Board を共有する。
+  ///
+  void resize(size_t count);
+
+  ///
+  /// カメラの数を得る
+  ///
+  /// @return 同時にキャプチャしているカメラの数
+  ///
+  auto getCount() const
+  {
+    return others.size() + 1;
+  }
+
+  ///
+  /// カメラの較正オブジェクトを取り出す
+  ///
+  /// @param index カメラの番号, 0 なら選択しているカメラ
+  /// @return カメラの較正オブジェクト
+  ///
+  Calibration& get(size_t index)
+  {
+    return index == 0 ? primary : others[index - 1];
+  }
+
+  ///
+  /// 同時に検出した ChArUco Board のコーナーを標本として記録する
+  ///
+  /// @note
+  /// 個々のカメラの内部パラメータの較正用の標本も記録する。
+  ///
+  void recordCorners();
+
+  ///
+  /// 記録した標本と較正結果を破棄する
+  ///
+  void discardCorners();
+
+  ///
+  /// カメラの相対的な姿勢を較正する
+  ///
+  /// @return 較正に成功したら true
+  ///
+  /// @note
+  /// 内部パラメータが求められていないカメラは先に内部パラメータを較正する。
+  ///
+  bool calibrate();
+
+  ///
+  /// 同時に検出した標本の数を得る
+  ///
+  /// @return 追加したカメラごとの標本の数の最小値
+  ///
+  int getSampleCount() const;
+
+  ///
+  /// 較正が完了したかどうかを調べる
+  ///
+  /// @return すべての追加したカメラの姿勢が求められていたら true
+  ///
+  bool finished() const;
+
+  ///
+  /// 追加したカメラの再投影誤差を得る
+  ///
+  /// @param index カメラの番号 (1 以上)
+  /// @return 再投影誤差
+  ///
+  auto getReprojectionError(size_t index) const
+  {
+    return errors[index - 1];
+  }
+
+  ///
+  /// キャリブレーションパラメータをファイルに保存する
+  ///
+  /// @param filename 保存するファイル名
+  /// @return パラメータの書き込みに成功したら true
+  ///
+  /// @note
+  /// 選択しているカメラのパラメータを最上位に置き、
+  /// 追加したカメラのパラメータと姿勢は "cameras" の配列に格納する。
+  ///
+  bool saveParameters(const std::string& filename) const;
+};
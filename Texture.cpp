@@ -7,10 +7,14 @@
 ///
 #include "Texture.h"
 
+// 標準ライブラリ
+#include <algorithm>
+
 //
 // テクスチャを作成するコンストラクタ
 //
 Texture::Texture(GLsizei width, GLsizei height, int channels)
+  : Texture{}
 {
   // テクスチャを作る
   Texture::create(width, height, channels);
@@ -20,6 +24,7 @@ Texture::Texture(GLsizei width, GLsizei height, int channels)
 // コピーコンストラクタ
 //
 Texture::Texture(const Texture& texture)
+  : Texture{}
 {
   // テクスチャをコピーして作成する
   Texture::copy(texture);
@@ -29,9 +34,11 @@ Texture::Texture(const Texture& texture)
 // ムーブコンストラクタ
 //
 Texture::Texture(Texture&& texture) noexcept
+  : Buffer{ std::move(texture) }
+  , textureSize{ std::exchange(texture.textureSize, std::array<int, 2>{ 0, 0 }) }
+  , textureChannels{ std::exchange(texture.textureChannels, 0) }
+  , textureName{ std::exchange(texture.textureName, 0) }
 {
-  // テクスチャをムーブして作成する
-  *this = std::move(texture);
 }
 
 //
@@ -58,25 +65,16 @@ void Texture::create(GLsizei width, GLsizei height, int channels)
   if (width == textureSize[0] && height == textureSize[1]
     && channels == textureChannels) return;
 
+  // 以前のテクスチャは再利用できるように戻す
+  ResourcePool::releaseTexture(textureName, textureSize[0], textureSize[1],
+    channelsToInternalFormat(textureChannels));
+
   // テクスチャのサイズとチャンネル数を記録する
   textureSize = std::array<int, 2>{ width, height };
   textureChannels = channels;
 
-  // 以前のテクスチャを削除する
-  glDeleteTextures(1, &textureName);
-
-  // テクスチャを作成する
-  glGenTextures(1, &textureName);
-
-  // テクスチャのメモリを確保してデータを転送する
-  glBindTexture(GL_TEXTURE_2D, textureName);
-  glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, width, height, 0,
-    channelsToFormat(channels), GL_UNSIGNED_BYTE, nullptr);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-  glBindTexture(GL_TEXTURE_2D, 0);
+  // チャネル数に合わせた内部フォーマットのテクスチャを取り出すか新しく作る
+  textureName = ResourcePool::acquireTexture(width, height, channelsToInternalFormat(channels));
 }
 
 //
@@ -116,14 +114,16 @@ Texture& Texture::operator=(Texture&& texture) noexcept
   // 代入元と代入先が同じでなければ
   if (&texture != this)
   {
-    // 引数のテクスチャをこのテクスチャにコピーする
-    Texture::copy(texture);
+    // ムーブ元のバッファを引き継ぐ
+    Buffer::operator=(std::move(texture));
 
-    // ムーブ元のバッファを破棄する
-    texture.Buffer::discard();
+    // このテクスチャを破棄して
+    Texture::discard();
 
-    // ムーブ元のテクスチャを破棄する
-    texture.Texture::discard();
+    // ムーブ元のテクスチャを引き継ぎ、ムーブ元は空にする
+    textureSize = std::exchange(texture.textureSize, std::array<int, 2>{ 0, 0 });
+    textureChannels = std::exchange(texture.textureChannels, 0);
+    textureName = std::exchange(texture.textureName, 0);
   }
 
   // このテクスチャを返す
@@ -138,8 +138,9 @@ void Texture::discard()
   // デフォルトのテクスチャに戻す
   glBindTexture(GL_TEXTURE_2D, 0);
 
-  // テクスチャを削除する
-  glDeleteTextures(1, &textureName);
+  // テクスチャを再利用できるように戻す
+  ResourcePool::releaseTexture(textureName, textureSize[0], textureSize[1],
+    channelsToInternalFormat(textureChannels));
   textureName = 0;
 
   // テクスチャのサイズを 0 にする
@@ -174,6 +175,99 @@ void Texture::draw(GLsizei width, GLsizei height, int unit) const
   unbindTexture();
 }
 
+//
+// 表示領域を格子状に分割した区画の一つにこのテクスチャをマッピングして矩形を描画する
+//
+void Texture::draw(GLsizei width, GLsizei height, int index, int count, int unit) const
+{
+  // 区画が一つなら表示領域全体に描画する
+  if (count <= 1)
+  {
+    draw(width, height, unit);
+    return;
+  }
+
+  // 区画の列数と行数
+  const auto cols{ static_cast<int>(ceil(sqrt(static_cast<double>(count)))) };
+  const auto rows{ (count + cols - 1) / cols };
+
+  // 描画する区画の列と行
+  const auto col{ index % cols };
+  const auto row{ index / cols };
+
+  // 現在のビューポート
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+
+  // 描画する区画のビューポート
+  const GLint x{ viewport[0] + viewport[2] * col / cols };
+  const GLint y{ viewport[1] + viewport[3] * (rows - row - 1) / rows };
+  const GLsizei w{ viewport[0] + viewport[2] * (col + 1) / cols - x };
+  const GLsizei h{ viewport[1] + viewport[3] * (rows - row) / rows - y };
+
+  // 描画する区画以外を塗りつぶさないようにする
+  glViewport(x, y, w, h);
+  glScissor(x, y, w, h);
+  glEnable(GL_SCISSOR_TEST);
+
+  // 区画に描画する
+  draw(width / cols, height / rows, unit);
+
+  // ビューポートを元に戻す
+  glDisable(GL_SCISSOR_TEST);
+  glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
+//
+// 表示領域を格子状に分割した区画の一つにこのテクスチャを展開して描画する
+//
+void Texture::expand(const std::array<GLsizei, 2>& size, int index, int count, int unit) const
+{
+  // まだメッシュの頂点配列オブジェクトが作られていなければ作る
+  if (!mesh) mesh = std::make_shared<Mesh>();
+
+  // 区画の列数と行数
+  const auto cols{ count > 1 ? static_cast<int>(ceil(sqrt(static_cast<double>(count)))) : 1 };
+  const auto rows{ (std::max(count, 1) + cols - 1) / cols };
+
+  // 描画する区画の列と行
+  const auto col{ index % cols };
+  const auto row{ index / cols };
+
+  // 現在のビューポート
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+
+  // 描画する区画
+  const GLint x{ viewport[0] + viewport[2] * col / cols };
+  const GLint y{ viewport[1] + viewport[3] * (rows - row - 1) / rows };
+  const GLsizei w{ viewport[0] + viewport[2] * (col + 1) / cols - x };
+  const GLsizei h{ viewport[1] + viewport[3] * (rows - row) / rows - y };
+
+  // 描画する区画だけを背景色で塗りつぶす
+  glScissor(x, y, w, h);
+  glEnable(GL_SCISSOR_TEST);
+  glClear(GL_COLOR_BUFFER_BIT);
+  glDisable(GL_SCISSOR_TEST);
+
+  // テクスチャが空なら塗りつぶすだけにする
+  if (getWidth() <= 0 || getHeight() <= 0) return;
+
+  // テクスチャの縦横比を保って区画の中央に収まるようにビューポートを設定する
+  const auto aspect{ getAspect() };
+  const auto vw{ std::min(w, static_cast<GLsizei>(h * aspect + 0.5f)) };
+  const auto vh{ std::min(h, static_cast<GLsizei>(w / aspect + 0.5f)) };
+  glViewport(x + (w - vw) / 2, y + (h - vh) / 2, vw, vh);
+
+  // このテクスチャを展開する
+  bindTexture(unit);
+  mesh->drawMesh(size);
+  unbindTexture();
+
+  // ビューポートを元に戻す
+  glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+}
+
 //
 // テクスチャからピクセルバッファオブジェクトにデータをコピーする
 //
@@ -196,9 +290,8 @@ std::vector<GLubyte>& buffer)
   GLuint currentFbo;
   glGetIntegerv(GL_FRAMEBUFFER_BINDING, reinterpret_cast<GLint*>(&currentFbo));
 
-  // テクスチャをカラーバッファに使ってフレームバッファオブジェクトを作る
-  GLuint fbo;
-  glGenFramebuffers(1, &fbo);
+  // 再利用するフレームバッファオブジェクトのカラーバッファにテクスチャを結合する
+  const auto fbo{ ResourcePool::acquireFramebuffer() };
   glBindFramebuffer(GL_FRAMEBUFFER, fbo);
   static const GLenum attachment{ GL_COLOR_ATTACHMENT0 };
   glFramebufferTexture2D(GL_FRAMEBUFFER, attachment, GL_TEXTURE_2D, textureName, 0);
@@ -212,8 +305,8 @@ std::vector<GLubyte>& buffer)
   // 元のフレームバッファオブジェクトに戻す
   glBindFramebuffer(GL_FRAMEBUFFER, currentFbo);
 
-  // 作ったフレームバッファオブジェクトは削除する
-  glDeleteFramebuffers(1, &fbo);
+  // 使ったフレームバッファオブジェクトは再利用できるように戻す
+  ResourcePool::releaseFramebuffer(fbo);
 #  else
   // テクスチャの内容をピクセルバッファオブジェクトに書き込む
   glGetTexImage(GL_TEXTURE_2D, 0, getFormat(), GL_UNSIGNED_BYTE, 0);
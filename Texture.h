@@ -67,6 +67,9 @@ public:
   ///
   /// @param texture ムーブ元のテクスチャ
   ///
+  /// @note
+  /// ムーブ元のテクスチャとピクセルバッファオブジェクトを引き継ぐ。
+  ///
   Texture(Texture&& texture) noexcept;
 
   ///
@@ -88,6 +91,9 @@ public:
   /// @param texture ムーブ代入元のテクスチャ
   /// @return ムーブ代入結果のテクスチャ
   ///
+  /// @note
+  /// このテクスチャを破棄してムーブ元のテクスチャとピクセルバッファオブジェクトを引き継ぐ。
+  ///
   Texture& operator=(Texture&& texture) noexcept;
 
   ///
@@ -99,7 +105,8 @@ public:
   ///
   /// @note
   /// このテクスチャのサイズが引数で指定したサイズと異なれば、
-  /// このテクスチャを削除して新しいテクスチャを作り直す。
+  /// このテクスチャを ResourcePool に戻して、同じサイズと内部フォーマットの
+  /// テクスチャを取り出すか新しく作る。内部フォーマットはチャネル数に合わせる。
   ///
   virtual void create(GLsizei width, GLsizei height, int channels);
 
@@ -157,7 +164,7 @@ public:
   /// unit には シェーダにおいてテクスチャのサンプラの uniform 変数に設定する
   /// GL_TEXTUREi の i と一致させること。
   ///
-  void bindTexture(int unit = 0) const
+  virtual void bindTexture(int unit = 0) const
   {
     // テクスチャユニットを指定する
     glActiveTexture(GL_TEXTURE0 + unit);
@@ -169,7 +176,7 @@ public:
   ///
   /// テクスチャの結合を解除する
   ///
-  void unbindTexture() const
+  virtual void unbindTexture() const
   {
     // デフォルトのテクスチャユニットに戻す
     glActiveTexture(GL_TEXTURE0);
@@ -192,6 +199,36 @@ public:
   ///
   void draw(GLsizei width, GLsizei height, int unit = 0) const;
 
+  ///
+  /// 表示領域を格子状に分割した区画の一つにこのテクスチャをマッピングして矩形を描画する
+  ///
+  /// @param width 表示領域の横の画素数
+  /// @param height 表示領域の縦の画素数
+  /// @param index 描画する区画の番号, 左上から右に数える
+  /// @param count 表示領域を分割する区画の数
+  /// @param unit 使用するテクスチャユニット番号
+  ///
+  /// @note
+  /// 表示領域は count 個の区画が入るように縦横ほぼ同じ数に分割する。
+  /// 描画する区画以外の表示領域は変更しない。
+  ///
+  void draw(GLsizei width, GLsizei height, int index, int count, int unit = 0) const;
+
+  ///
+  /// 表示領域を格子状に分割した区画の一つにこのテクスチャを展開して描画する
+  ///
+  /// @param size 展開に用いるメッシュの分割数
+  /// @param index 描画する区画の番号, 左上から右に数える
+  /// @param count 表示領域を分割する区画の数
+  /// @param unit 使用するテクスチャユニット番号
+  ///
+  /// @note
+  /// フレームバッファオブジェクトを介さずに、区画の中にテクスチャの縦横比を保って
+  /// 展開用シェーダでメッシュを描画する。これより前で展開用シェーダの設定を
+  /// 上下を反転するように行う。描画する区画以外の表示領域は変更しない。
+  ///
+  void expand(const std::array<GLsizei, 2>& size, int index, int count, int unit = 0) const;
+
   ///
   /// テクスチャから指定したピクセルバッファオブジェクトにデータをコピーする
   ///
@@ -0,0 +1,222 @@
+﻿///
+/// Video for Linux のキャプチャデバイスの列挙の実装
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 19, 2026
+///
+#include "V4l2Device.h"
+
+// 標準ライブラリ
+#include <algorithm>
+#include <cstring>
+#include <tuple>
+
+#if defined(__linux__)
+// Video for Linux
+#include <cerrno>
+#include <fcntl.h>
+#include <filesystem>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#include <linux/videodev2.h>
+
+//
+// シグナルで中断されても ioctl を繰り返す
+//
+static int xioctl(int fd, unsigned long request, void* arg)
+{
+  int status;
+  do status = ioctl(fd, request, arg); while (status < 0 && errno == EINTR);
+  return status;
+}
+
+//
+// 撮影モードを追加する
+//
+static void addMode(std::vector<V4l2Mode>& modes, const v4l2_fmtdesc& format,
+  int width, int height, double fps)
+{
+  V4l2Mode mode{};
+  for (int i = 0; i < 4; ++i) mode.fourcc[i] = static_cast<char>((format.pixelformat >> (i * 8)) & 0xff);
+  mode.size = { width, height };
+  mode.fps = fps;
+  mode.compressed = (format.flags & V4L2_FMT_FLAG_COMPRESSED) != 0;
+  modes.emplace_back(mode);
+}
+
+//
+// 画素の形式と解像度に対して選択できるフレームレートについて撮影モードを追加する
+//
+static void addIntervals(int fd, std::vector<V4l2Mode>& modes, const v4l2_fmtdesc& format,
+  int width, int height)
+{
+  v4l2_frmivalenum interval{};
+  interval.pixel_format = format.pixelformat;
+  interval.width = width;
+  interval.height = height;
+
+  // フレーム間隔を列挙する
+  while (xioctl(fd, VIDIOC_ENUM_FRAMEINTERVALS, &interval) == 0)
+  {
+    if (interval.type == V4L2_FRMIVAL_TYPE_DISCRETE)
+    {
+      // 離散的なフレーム間隔ならそれぞれのフレームレートを追加する
+      const auto& f{ interval.discrete };
+      if (f.numerator > 0) addMode(modes, format, width, height, static_cast<double>(f.denominator) / f.numerator);
+      ++interval.index;
+    }
+    else
+    {
+      // 連続的なフレーム間隔なら最大のフレームレートを追加する
+      const auto& f{ interval.stepwise.min };
+      if (f.numerator > 0) addMode(modes, format, width, height, static_cast<double>(f.denominator) / f.numerator);
+      return;
+    }
+  }
+
+  // フレーム間隔が得られなかったらフレームレートは不明とする
+  if (interval.index == 0) addMode(modes, format, width, height, 0.0);
+}
+
+//
+// キャプチャデバイスが対応している撮影モードを列挙する
+//
+static void enumerateModes(int fd, std::vector<V4l2Mode>& modes)
+{
+  v4l2_fmtdesc format{};
+  format.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+
+  // 画素の形式を列挙する
+  for (; xioctl(fd, VIDIOC_ENUM_FMT, &format) == 0; ++format.index)
+  {
+    // ドライバがソフトウェアで変換している形式は使わない
+    if (format.flags & V4L2_FMT_FLAG_EMULATED) continue;
+
+    v4l2_frmsizeenum frame{};
+    frame.pixel_format = format.pixelformat;
+
+    // 解像度を列挙する
+    while (xioctl(fd, VIDIOC_ENUM_FRAMESIZES, &frame) == 0)
+    {
+      if (frame.type == V4L2_FRMSIZE_TYPE_DISCRETE)
+      {
+        // 離散的な解像度ならそれぞれの解像度を追加する
+        addIntervals(fd, modes, format, frame.discrete.width, frame.discrete.height);
+        ++frame.index;
+      }
+      else
+      {
+        // 連続的な解像度なら最小と最大の解像度を追加する
+        addIntervals(fd, modes, format, frame.stepwise.min_width, frame.stepwise.min_height);
+        addIntervals(fd, modes, format, frame.stepwise.max_width, frame.stepwise.max_height);
+        break;
+      }
+    }
+  }
+}
+#endif
+
+//
+// 画素の形式の転送の効率の順位を得る
+//
+int V4l2Mode::getRank() const
+{
+  // 無変換で転送して GPU で色変換できる形式
+  if (std::strcmp(fourcc.data(), "YUYV") == 0 || std::strcmp(fourcc.data(), "NV12") == 0) return 3;
+
+  // CPU で復号する形式
+  if (std::strcmp(fourcc.data(), "MJPG") == 0) return 2;
+
+  // その他の非圧縮の形式は CPU で色変換する
+  return compressed ? 0 : 1;
+}
+
+//
+// 指定した解像度で最も高いスループットが得られる撮影モードを選ぶ
+//
+const V4l2Mode* V4l2Device::selectMode(const std::array<int, 2>& size, double fps) const
+{
+  // 使える撮影モードの中で指定した解像度を下回らない最小の解像度と最大の解像度を求める
+  std::array<int, 2> smallest{ 0, 0 }, largest{ 0, 0 };
+  const auto area = [](const std::array<int, 2>& s) { return static_cast<long long>(s[0]) * s[1]; };
+  for (const auto& mode : modes)
+  {
+    // 使えない形式は除く
+    if (mode.getRank() == 0) continue;
+
+    if (area(mode.size) > area(largest)) largest = mode.size;
+    if (mode.size[0] >= size[0] && mode.size[1] >= size[1]
+      && (area(smallest) == 0 || area(mode.size) < area(smallest))) smallest = mode.size;
+  }
+
+  // 解像度を指定していないか足りる解像度がなければ最大の解像度にする
+  const auto target{ size[0] <= 0 || size[1] <= 0 || area(smallest) == 0 ? largest : smallest };
+
+  // 決めた解像度の撮影モードの中から選ぶ
+  const V4l2Mode* selected{ nullptr };
+  for (const auto& mode : modes)
+  {
+    if (mode.size != target || mode.getRank() == 0) continue;
+
+    // 期待するフレームレートに届いているかどうかを優先し、次に転送の効率、最後にフレームレートで比べる
+    const auto score = [fps](const V4l2Mode& m)
+    {
+      return std::make_tuple(fps > 0.0 ? std::min(m.fps, fps) : m.fps, m.getRank(), m.fps);
+    };
+    if (!selected || score(mode) > score(*selected)) selected = &mode;
+  }
+
+  return selected;
+}
+
+//
+// Video for Linux のキャプチャデバイスを列挙する
+//
+std::vector<V4l2Device> enumerateV4l2Devices()
+{
+  std::vector<V4l2Device> devices;
+
+#if defined(__linux__)
+  // /dev/video* のデバイスファイルについて
+  std::error_code error;
+  for (const auto& entry : std::filesystem::directory_iterator{ "/dev", error })
+  {
+    const auto file{ entry.path().filename().string() };
+    if (file.compare(0, 5, "video") != 0 || file.size() == 5
+      || !std::all_of(file.begin() + 5, file.end(), ::isdigit)) continue;
+
+    // デバイスファイルを開く
+    const auto path{ entry.path().string() };
+    const int fd{ open(path.c_str(), O_RDWR | O_NONBLOCK) };
+    if (fd < 0) continue;
+
+    // 映像を入力できるキャプチャデバイスなら
+    v4l2_capability capability{};
+    if (xioctl(fd, VIDIOC_QUERYCAP, &capability) == 0)
+    {
+      const auto caps{ (capability.capabilities & V4L2_CAP_DEVICE_CAPS)
+        ? capability.device_caps : capability.capabilities };
+      if ((caps & V4L2_CAP_VIDEO_CAPTURE) && (caps & V4L2_CAP_STREAMING))
+      {
+        // キャプチャデバイスを追加して撮影モードを列挙する
+        V4l2Device device;
+        device.index = std::stoi(file.substr(5));
+        device.path = path;
+        device.name = std::string(reinterpret_cast<const char*>(capability.card)) + " (" + path + ")";
+        enumerateModes(fd, device.modes);
+        devices.emplace_back(std::move(device));
+      }
+    }
+
+    // デバイスファイルを閉じる
+    close(fd);
+  }
+
+  // デバイスファイルの番号順に並べる
+  std::sort(devices.begin(), devices.end(),
+    [](const V4l2Device& a, const V4l2Device& b) { return a.index < b.index; });
+#endif
+
+  return devices;
+}
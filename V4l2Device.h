@@ -0,0 +1,84 @@
+﻿#pragma once
+
+///
+/// Video for Linux のキャプチャデバイスの列挙の定義
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 19, 2026
+///
+
+// 標準ライブラリ
+#include <array>
+#include <string>
+#include <vector>
+
+///
+/// Video for Linux のキャプチャデバイスの撮影モード
+///
+struct V4l2Mode
+{
+  /// 画素の形式の 4 文字
+  std::array<char, 5> fourcc;
+
+  /// フレームの横と縦の画素数
+  std::array<int, 2> size;
+
+  /// フレームレート
+  double fps;
+
+  /// 圧縮された形式なら true
+  bool compressed;
+
+  ///
+  /// 画素の形式の転送の効率の順位を得る
+  ///
+  /// @return 転送の効率が高い形式ほど大きな値, 使えない形式なら 0
+  ///
+  /// @note
+  /// YUYV と NV12 は無変換で転送して GPU で色変換できるので最も高く、
+  /// MJPEG は CPU で復号する必要があるのでその次にする。
+  ///
+  int getRank() const;
+};
+
+///
+/// Video for Linux のキャプチャデバイス
+///
+struct V4l2Device
+{
+  /// デバイスファイルの番号 (/dev/videoN の N)
+  int index;
+
+  /// デバイスファイルのパス
+  std::string path;
+
+  /// キャプチャデバイスの名前
+  std::string name;
+
+  /// キャプチャデバイスが対応している撮影モード
+  std::vector<V4l2Mode> modes;
+
+  ///
+  /// 指定した解像度で最も高いスループットが得られる撮影モードを選ぶ
+  ///
+  /// @param size 期待するフレームの横と縦の画素数, 0 なら最大の解像度
+  /// @param fps 期待するフレームレート, 0 なら最大のフレームレート
+  /// @return 選んだ撮影モードのポインタ, 使える撮影モードがなければ nullptr
+  ///
+  /// @note
+  /// 指定した解像度の撮影モードがなければ、それを下回らない最小の解像度の撮影モードから選ぶ。
+  /// 期待するフレームレートに届くものを優先し、その中で転送の効率が高い形式を選ぶ。
+  ///
+  const V4l2Mode* selectMode(const std::array<int, 2>& size, double fps) const;
+};
+
+///
+/// Video for Linux のキャプチャデバイスを列挙する
+///
+/// @return 映像を入力できるキャプチャデバイスのリスト
+///
+/// @note
+/// Linux 以外では空のリストを返す。
+///
+std::vector<V4l2Device> enumerateV4l2Devices();
@@ -0,0 +1,420 @@
+﻿///
+/// ChArUco Board の検出と較正のベンチマーク
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 19, 2026
+///
+/// @description
+/// Calibration::drawBoard() で描いた ChArUco Board を、既知の内部パラメータと
+/// 歪み係数をもつ仮想カメラで複数の姿勢から撮影した合成画像を VGA から 4K まで
+/// の解像度で作り、detectBoard()、detectMarkers()、recordCorners()、calibrate()
+/// の処理時間と、真値に対するコーナーの検出誤差と較正結果の誤差を計測して、
+/// 結果を JSON で標準出力に書き出す。ChArUco Board のコーナーのサブピクセル精度の
+/// 補正は窓の大きさを変えて計測し、処理時間と精度の兼ね合いを比べられるようにする。
+///
+/// 引数に以前の結果の JSON ファイルを指定すると、処理時間がそれより大きく
+/// 増えていないかも調べる。精度が許容範囲を外れるか処理時間が増えていたら
+/// 終了コード 1 で終了する。
+///
+#include "Calibration.h"
+
+// OpenCV
+#include <opencv2/calib3d.hpp>
+
+// 標準ライブラリ
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+// 計測する解像度
+constexpr std::array<std::array<int, 2>, 4> resolutions
+{
+  {
+    { 640, 480 },
+    { 1280, 720 },
+    { 1920, 1080 },
+    { 3840, 2160 }
+  }
+};
+
+// 計測するコーナーのサブピクセル精度の補正の窓の大きさの半分 (0 は補正しない)
+constexpr std::array<int, 3> subPixelWindows{ 0, 3, 5 };
+
+// 一つの姿勢について検出を繰り返す回数
+constexpr int repeat{ 5 };
+
+// ChArUco Board のマス目の一辺の長さと ArUco Marker の一辺の長さ (単位 cm)
+constexpr std::array<float, 2> checkerLength{ 4.0f, 2.0f };
+
+// ChArUco Board のマス目の数
+constexpr int squaresX{ 10 }, squaresY{ 7 };
+
+// Calibration::drawBoard() が ChArUco Board の周囲に置く余白の画素数
+constexpr int boardMargin{ 10 };
+
+// 精度の許容範囲
+constexpr double minDetectionRate{ 0.9 };
+constexpr double maxCornerError{ 0.5 };
+constexpr double maxFocalError{ 0.01 };
+constexpr double maxCenterError{ 2.0 };
+
+// 以前の結果に対して許容する処理時間の増加率
+constexpr double maxSlowdown{ 1.25 };
+
+//
+// 時間を計測する
+//
+template <typename Func>
+double measure(Func&& func)
+{
+  const auto start{ std::chrono::steady_clock::now() };
+  func();
+  const auto end{ std::chrono::steady_clock::now() };
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+//
+// 処理時間の統計
+//
+struct Timing
+{
+  // 計測回数
+  int count{ 0 };
+
+  // 合計と最小値 (ミリ秒)
+  double total{ 0.0 }, minimum{ std::numeric_limits<double>::max() };
+
+  // 計測結果を追加する
+  void add(double time)
+  {
+    ++count;
+    total += time;
+    minimum = std::min(minimum, time);
+  }
+
+  // 平均 (ミリ秒)
+  double mean() const
+  {
+    return count > 0 ? total / count : 0.0;
+  }
+
+  // JSON オブジェクトにする
+  picojson::value toJson() const
+  {
+    picojson::object object;
+    setValue(object, "mean", mean());
+    setValue(object, "min", count > 0 ? minimum : 0.0);
+    setValue(object, "count", count);
+    return picojson::value{ object };
+  }
+};
+
+//
+// 仮想カメラで撮影する ChArUco Board の姿勢を求める
+//
+static std::vector<std::pair<cv::Vec3d, cv::Vec3d>> makePoses(double distance)
+{
+  // ChArUco Board の中心
+  const cv::Vec3d center{
+    squaresX * checkerLength[0] * 0.005, squaresY * checkerLength[0] * 0.005, 0.0 };
+
+  // 姿勢のリスト
+  std::vector<std::pair<cv::Vec3d, cv::Vec3d>> poses;
+
+  // ChArUco Board を傾ける角度 (度)
+  constexpr double tilts[]{ -30.0, 0.0, 30.0 };
+
+  // ChArUco Board を傾けるすべての組み合わせについて
+  for (const auto tx : tilts)
+  {
+    for (const auto ty : tilts)
+    {
+      // 傾けていない姿勢では面内で回転する
+      const auto rz{ tx == 0.0 && ty == 0.0 ? 15.0 : 0.0 };
+
+      // 回転ベクトル
+      const cv::Vec3d rvec{ tx * CV_PI / 180.0, ty * CV_PI / 180.0, rz * CV_PI / 180.0 };
+
+      // ChArUco Board の中心が光軸から少しずれた位置に来るようにする
+      cv::Matx33d r;
+      cv::Rodrigues(rvec, r);
+      const cv::Vec3d offset{ ty * 0.001, tx * 0.001, distance };
+      poses.emplace_back(rvec, offset - r * center);
+    }
+  }
+
+  // 正対した姿勢で遠近を変える
+  poses.emplace_back(cv::Vec3d{ 0.0, 0.0, 0.0 }, cv::Vec3d{ 0.0, 0.0, distance * 0.8 } - center);
+  poses.emplace_back(cv::Vec3d{ 0.0, 0.0, 0.0 }, cv::Vec3d{ 0.0, 0.0, distance * 1.3 } - center);
+  poses.emplace_back(cv::Vec3d{ 0.2, -0.2, 0.0 }, cv::Vec3d{ 0.0, 0.0, distance * 1.1 } - center);
+
+  return poses;
+}
+
+//
+// 一つの解像度とサブピクセル精度の補正の窓の大きさで計測する
+//
+static picojson::object run(int width, int height, int subPixelWindow, bool& passed)
+{
+  // 仮想カメラの内部パラメータと歪み係数
+  const auto focal{ 0.8 * width };
+  const cv::Matx33d cameraMatrix{
+    focal, 0.0, width * 0.5,
+    0.0, focal, height * 0.5,
+    0.0, 0.0, 1.0 };
+  const cv::Matx<double, 1, 5> distCoeffs{ -0.12, 0.03, 0.0, 0.0, 0.0 };
+
+  // 検出の設定
+  DetectorSettings detectorSettings;
+  detectorSettings.subPixelWindow = subPixelWindow;
+
+  // 較正オブジェクト
+  Calibration calibration{ "DICT_4X4_50", checkerLength, { squaresX, squaresY }, detectorSettings };
+
+  // ChArUco Board の画像をマス目一つが出力画像の幅の 1/10 になるように描く
+  const int square{ std::max(width / 10, 32) };
+  cv::Mat board;
+  calibration.drawBoard(board, squaresX * square + boardMargin * 2,
+    squaresY * square + boardMargin * 2);
+  if (board.channels() == 1) cv::cvtColor(board, board, cv::COLOR_GRAY2BGR);
+
+  // ChArUco Board 上の位置 (m) から ChArUco Board の画像上の画素の中心の位置への変換
+  const auto scale{ square / (checkerLength[0] * 0.01) };
+  const cv::Matx33d toBoard{
+    scale, 0.0, boardMargin - 0.5,
+    0.0, scale, boardMargin - 0.5,
+    0.0, 0.0, 1.0 };
+
+  // 出力画像の各画素の歪みを取り除いた正規化座標を求めておく
+  cv::Mat pixels(height * width, 1, CV_32FC2);
+  for (int y = 0; y < height; ++y)
+    for (int x = 0; x < width; ++x)
+      pixels.at<cv::Vec2f>(y * width + x) = cv::Vec2f{ static_cast<float>(x), static_cast<float>(y) };
+  cv::Mat normalized;
+  cv::undistortPoints(pixels, normalized, cameraMatrix, distCoeffs, cv::noArray(), cv::noArray(),
+    cv::TermCriteria{ cv::TermCriteria::COUNT | cv::TermCriteria::EPS, 20, 1.0e-9 });
+  normalized = normalized.reshape(2, height);
+
+  // ChArUco Board 上のコーナーの位置
+  const auto& chessboard{ calibration.getBoard()->getChessboardCorners() };
+
+  // ChArUco Board が画面の幅の 6 割程度に写る距離
+  const auto distance{ focal * squaresX * checkerLength[0] * 0.01 / (0.6 * width) };
+
+  // 処理時間
+  Timing detectBoard, detectMarkers, recordCorners, calibrate;
+
+  // コーナーの検出誤差の二乗和と検出数と画面内にあるコーナーの数
+  double squaredError{ 0.0 };
+  int detected{ 0 }, visible{ 0 };
+
+  // 検出した ArUco Marker の数
+  int markers{ 0 };
+
+  // 画像に加える雑音の乱数
+  cv::RNG rng{ 0x12345678 };
+
+  // すべての姿勢について
+  for (const auto& pose : makePoses(distance))
+  {
+    // ChArUco Board 上の位置から正規化座標へのホモグラフィ
+    cv::Matx33d r;
+    cv::Rodrigues(pose.first, r);
+    const cv::Matx33d homography{
+      r(0, 0), r(0, 1), pose.second[0],
+      r(1, 0), r(1, 1), pose.second[1],
+      r(2, 0), r(2, 1), pose.second[2] };
+
+    // 出力画像の各画素に対応する ChArUco Board の画像上の位置を求める
+    cv::Mat map;
+    cv::perspectiveTransform(normalized, map, toBoard * homography.inv());
+
+    // ChArUco Board を撮影した画像を合成して雑音を加える
+    cv::Mat scene;
+    cv::remap(board, scene, map, cv::noArray(), cv::INTER_LINEAR,
+      cv::BORDER_CONSTANT, cv::Scalar::all(96));
+    cv::Mat noise{ scene.size(), CV_16SC3 };
+    rng.fill(noise, cv::RNG::NORMAL, 0.0, 2.0);
+    scene.convertTo(scene, CV_16SC3);
+    scene += noise;
+    scene.convertTo(scene, CV_8UC3);
+
+    // コーナーの真の位置
+    std::vector<cv::Point2f> truth;
+    cv::projectPoints(chessboard, pose.first, pose.second, cameraMatrix, distCoeffs, truth);
+
+    // 画面内にあるコーナーの数を数える
+    const cv::Rect2f frame{ 0.0f, 0.0f, static_cast<float>(width), static_cast<float>(height) };
+    for (const auto& point : truth) if (frame.contains(point)) ++visible;
+
+    // ChArUco Board の検出を繰り返す
+    for (int i = 0; i < repeat; ++i)
+    {
+      // 検出結果が描き込まれるので複製して使う
+      cv::Mat image{ scene.clone() };
+      detectBoard.add(measure([&] { calibration.detectBoard(image); }));
+    }
+
+    // 最後の検出結果の誤差を求める
+    const auto& corners{ calibration.getCharucoCorners() };
+    const auto& ids{ calibration.getCharucoIds() };
+    for (size_t i = 0; i < ids.size(); ++i)
+    {
+      const auto d{ corners[i] - truth[ids[i]] };
+      squaredError += d.dot(d);
+    }
+    detected += static_cast<int>(ids.size());
+
+    // 検出したコーナーを標本として記録する
+    recordCorners.add(measure([&] { calibration.recordCorners(); }));
+
+    // ArUco Marker の検出を繰り返す
+    for (int i = 0; i < repeat; ++i)
+    {
+      cv::Mat image{ scene.clone() };
+      detectMarkers.add(measure([&] { calibration.detectMarkers(image, checkerLength[1]); }));
+    }
+    markers += calibration.getCornersCount();
+  }
+
+  // 較正する
+  bool calibrated{ false };
+  calibrate.add(measure([&] { calibrated = calibration.calibrate() && calibration.finished(); }));
+
+  // 計測結果
+  picojson::object result;
+  setValue(result, "width", width);
+  setValue(result, "height", height);
+  setValue(result, "subPixelWindow", subPixelWindow);
+  setValue(result, "views", detectMarkers.count / repeat);
+  result.emplace("detectBoard", detectBoard.toJson());
+  result.emplace("detectMarkers", detectMarkers.toJson());
+  result.emplace("recordCorners", recordCorners.toJson());
+  result.emplace("calibrate", calibrate.toJson());
+
+  // コーナーの検出率と検出誤差
+  const auto detectionRate{ visible > 0 ? static_cast<double>(detected) / visible : 0.0 };
+  const auto cornerError{ detected > 0 ? std::sqrt(squaredError / detected) : 0.0 };
+  setValue(result, "detection rate", detectionRate);
+  setValue(result, "corner error", cornerError);
+  setValue(result, "markers", markers);
+
+  // 較正結果の誤差
+  double focalError{ 1.0 }, centerError{ static_cast<double>(width) };
+  if (calibrated)
+  {
+    const cv::Matx33d estimated{ calibration.getCameraMatrix() };
+    focalError = std::max(std::abs(estimated(0, 0) - focal), std::abs(estimated(1, 1) - focal)) / focal;
+    centerError = std::hypot(estimated(0, 2) - cameraMatrix(0, 2), estimated(1, 2) - cameraMatrix(1, 2));
+  }
+  setValue(result, "reprojection error", calibration.getReprojectionError());
+  setValue(result, "focal error", focalError);
+  setValue(result, "center error", centerError);
+
+  // 精度が許容範囲内か調べる
+  const bool accurate{ detectionRate >= minDetectionRate && cornerError <= maxCornerError
+    && focalError <= maxFocalError && centerError <= maxCenterError };
+  result.emplace("accurate", picojson::value{ accurate });
+  if (!accurate)
+  {
+    std::cerr << width << "x" << height << " (subPixelWindow " << subPixelWindow
+      << "): accuracy out of range\n";
+    passed = false;
+  }
+
+  return result;
+}
+
+//
+// 計測結果のサブピクセル精度の補正の窓の大きさを得る
+//
+static double getSubPixelWindow(const picojson::value& result)
+{
+  // 補正の窓の大きさがない以前の結果は補正していない
+  const auto& window{ result.get("subPixelWindow") };
+  return window.is<double>() ? window.get<double>() : 0.0;
+}
+
+//
+// 以前の結果と処理時間を比べる
+//
+static void compare(const picojson::array& results, const std::string& filename, bool& passed)
+{
+  // 以前の結果を読み込む
+  std::ifstream json{ filename };
+  if (!json)
+  {
+    std::cerr << "Cannot open " << filename << "\n";
+    passed = false;
+    return;
+  }
+  picojson::value value;
+  json >> value;
+  if (!value.is<picojson::object>() || !value.get("results").is<picojson::array>()) return;
+  const auto& baseline{ value.get("results").get<picojson::array>() };
+
+  // 同じ解像度の結果について
+  for (const auto& current : results)
+  {
+    for (const auto& previous : baseline)
+    {
+      if (!previous.is<picojson::object>()
+        || !previous.get("width").is<double>() || !previous.get("height").is<double>()
+        || previous.get("width").get<double>() != current.get("width").get<double>()
+        || previous.get("height").get<double>() != current.get("height").get<double>()
+        || getSubPixelWindow(previous) != getSubPixelWindow(current)) continue;
+
+      // 処理ごとに最小値を比べる
+      for (const auto* const name : { "detectBoard", "detectMarkers", "recordCorners", "calibrate" })
+      {
+        const auto& before{ previous.get(name).get("min") };
+        const auto& after{ current.get(name).get("min") };
+        if (!before.is<double>() || !after.is<double>()) continue;
+
+        // 処理時間が許容範囲を超えて増えていたら
+        if (after.get<double>() > before.get<double>() * maxSlowdown)
+        {
+          std::cerr << current.get("width").get<double>() << "x" << current.get("height").get<double>()
+            << ": " << name << " slowed down from " << before.get<double>()
+            << " ms to " << after.get<double>() << " ms\n";
+          passed = false;
+        }
+      }
+    }
+  }
+}
+
+//
+// メインプログラム
+//
+int main(int argc, const char* const* argv)
+{
+  // すべての計測が許容範囲内なら true
+  bool passed{ true };
+
+  // すべての解像度とサブピクセル精度の補正の窓の大きさについて計測する
+  picojson::array results;
+  for (const auto& resolution : resolutions)
+  {
+    for (const auto subPixelWindow : subPixelWindows)
+    {
+      results.emplace_back(run(resolution[0], resolution[1], subPixelWindow, passed));
+    }
+  }
+
+  // 以前の結果が指定されていれば処理時間を比べる
+  if (argc > 1) compare(results, argv[1], passed);
+
+  // 計測結果を書き出す
+  picojson::object object;
+  setString(object, "opencv", CV_VERSION);
+  setValue(object, "threads", cv::getNumThreads());
+  object.emplace("results", results);
+  object.emplace("passed", picojson::value{ passed });
+  std::cout << picojson::value{ object }.serialize(true);
+
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,265 @@
+﻿///
+/// フレームの転送と展開のベンチマーク
+///
+/// @file
+/// @author Kohe Tokoi
+/// @date October 19, 2026
+///
+/// @description
+/// 表示しない GLFW のウィンドウを開き、calib_config.json に記述されている
+/// すべての展開用シェーダについて、複数の解像度とメッシュのサンプル点数で
+/// ピクセルバッファオブジェクトへの転送と Frame::drawPixels() によるテクスチャへの
+/// 転送、Framebuffer::update() による展開、Framebuffer::readPixels() による読み出しに
+/// 要する時間を計測して、結果を JSON で標準出力に書き出す。
+///
+/// 計測は処理のたびに glFinish() で完了を待つ CPU の時間で行うので、GPU のない
+/// 環境でも Mesa の llvmpipe で実行できる (xvfb-run と LIBGL_ALWAYS_SOFTWARE=1 を使う)。
+/// 引数に --egl を指定すると EGL でコンテキストを作成する。
+///
+/// 使い方: bench_expand [--egl] [--format interleaved|yuyv|nv12] [--frames 回数] [構成ファイル]
+///
+#include "Preference.h"
+
+// フレームとフレームバッファオブジェクト
+#include "Frame.h"
+#include "Framebuffer.h"
+
+// 標準ライブラリ
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <set>
+#include <vector>
+
+// 計測する解像度
+constexpr std::array<std::array<int, 2>, 4> resolutions
+{
+  {
+    { 640, 480 },
+    { 1280, 720 },
+    { 1920, 1080 },
+    { 3840, 2160 }
+  }
+};
+
+// 計測するメッシュのサンプル点数
+constexpr std::array<int, 3> sampleCounts{ 14400, 57600, 230400 };
+
+// 計測前に空回しするフレーム数
+constexpr int warmup{ 3 };
+
+// 展開時の焦点距離 (Settings::getFocal() のデフォルト値)
+constexpr GLfloat focal{ 50.0f / 17.5f };
+
+// 展開後のフレームの境界色
+constexpr std::array<GLfloat, 4> border{ 0.0f, 0.0f, 0.0f, 1.0f };
+
+//
+// 処理を実行して完了までの時間を計測する
+//
+template <typename Func>
+double measure(Func&& func)
+{
+  const auto start{ std::chrono::steady_clock::now() };
+  func();
+  glFinish();
+  const auto end{ std::chrono::steady_clock::now() };
+  return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+//
+// 一つの組み合わせで計測する
+//
+static picojson::object run(const Preference& preference, int width, int height, int samples,
+  FrameFormat format, int frames)
+{
+  // キャプチャしたフレームを保持するテクスチャ
+  Frame frame;
+  frame.create(width, height, 3, format);
+
+  // フレームを展開するフレームバッファオブジェクト
+  Framebuffer framebuffer{ width, height };
+
+  // キャプチャデバイスから転送するデータ
+  const auto& bufferSize{ frame.Buffer::getSize() };
+  const auto bytes{ static_cast<size_t>(bufferSize[0]) * bufferSize[1] * frame.Buffer::getChannels() };
+  std::vector<GLubyte> pixels(bytes);
+  for (size_t i = 0; i < bytes; ++i) pixels[i] = static_cast<GLubyte>(i * 7 + (i >> 11));
+
+  // キャプチャデバイス固有のパラメータ
+  const auto& intrinsics{ preference.getIntrinsics() };
+
+  // 処理時間の合計
+  double transmit{ 0.0 }, upload{ 0.0 }, expand{ 0.0 }, readback{ 0.0 };
+
+  // 空回しと計測を繰り返す
+  for (int i = -warmup; i < frames; ++i)
+  {
+    // ピクセルバッファオブジェクトに転送する (Camera::transmit() と同じ)
+    const auto t0{ measure([&] {
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, frame.getBufferName());
+      glBufferSubData(GL_PIXEL_PACK_BUFFER, 0, bytes, pixels.data());
+      glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    }) };
+
+    // ピクセルバッファオブジェクトからテクスチャに転送する
+    const auto t1{ measure([&] { frame.drawPixels(); }) };
+
+    // フレームバッファオブジェクトに展開する
+    const auto t2{ measure([&] {
+      const auto&& size{ preference.getShader().setup(samples, framebuffer.getAspect(),
+        gg::ggIdentity(), intrinsics.fov, intrinsics.center, focal, border, format) };
+      framebuffer.update(size, frame);
+    }) };
+
+    // フレームバッファオブジェクトの内容を読み出して CPU から参照する
+    const auto t3{ measure([&] {
+      framebuffer.readPixels();
+      volatile GLubyte sink{ static_cast<const GLubyte*>(framebuffer.map())[0] };
+      static_cast<void>(sink);
+      framebuffer.unmap();
+    }) };
+
+    // 空回しでなければ集計する
+    if (i >= 0)
+    {
+      transmit += t0;
+      upload += t1;
+      expand += t2;
+      readback += t3;
+    }
+  }
+
+  // 計測結果
+  picojson::object result;
+  setString(result, "description", preference.getDescription());
+  setValue(result, "width", width);
+  setValue(result, "height", height);
+  setValue(result, "samples", samples);
+  setValue(result, "transmit", transmit / frames);
+  setValue(result, "drawPixels", upload / frames);
+  setValue(result, "update", expand / frames);
+  setValue(result, "readPixels", readback / frames);
+
+  // 転送帯域 (MB/s)
+  const auto readBytes{ static_cast<double>(width) * height * framebuffer.getChannels() };
+  setValue(result, "upload bandwidth", bytes * frames / ((transmit + upload) * 1.0e3));
+  setValue(result, "readback bandwidth", readBytes * frames / (readback * 1.0e3));
+
+  return result;
+}
+
+//
+// メインプログラム
+//
+int main(int argc, const char* const* argv) try
+{
+  // 構成ファイル名
+  std::string filename{ "calib_config.json" };
+
+  // 展開するフレームの画素の格納形式
+  FrameFormat format{ FrameFormat::INTERLEAVED };
+
+  // 計測するフレーム数
+  int frames{ 20 };
+
+  // EGL を使うなら true
+  bool egl{ false };
+
+  // 引数を解釈する
+  for (int i = 1; i < argc; ++i)
+  {
+    if (std::strcmp(argv[i], "--egl") == 0) egl = true;
+    else if (std::strcmp(argv[i], "--frames") == 0 && i + 1 < argc) frames = std::max(std::atoi(argv[++i]), 1);
+    else if (std::strcmp(argv[i], "--format") == 0 && i + 1 < argc)
+    {
+      const std::string name{ argv[++i] };
+      format = name == "yuyv" ? FrameFormat::YUYV : name == "nv12" ? FrameFormat::NV12 : FrameFormat::INTERLEAVED;
+    }
+    else filename = argv[i];
+  }
+
+  // GLFW を初期化する
+  if (glfwInit() == GL_FALSE) throw std::runtime_error("Can't initialize GLFW");
+
+  // 表示しないウィンドウのコンテキストを作成する
+  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#if defined(GL_GLES_PROTOTYPES)
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+  glfwWindowHint(GLFW_CLIENT_API, GLFW_OPENGL_ES_API);
+  glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+#else
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
+  glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 1);
+  glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+  glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+  if (egl) glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+#endif
+  GLFWwindow* const window{ glfwCreateWindow(64, 64, "bench_expand", nullptr, nullptr) };
+  if (!window) throw std::runtime_error("Unable to open the GLFW window.");
+  glfwMakeContextCurrent(window);
+  gg::ggInit();
+
+  // 計測結果
+  picojson::object object;
+  {
+    // 構成ファイルを読み込む
+    std::ifstream json{ filename };
+    if (!json) throw std::runtime_error("Cannot open " + filename);
+    picojson::value value;
+    json >> value;
+    if (!value.is<picojson::object>() || !value.get("camera").is<picojson::array>())
+      throw std::runtime_error("No camera preferences in " + filename);
+
+    // すべての構成のシェーダをビルドする
+    std::vector<Preference> preferences;
+    for (const auto& camera : value.get("camera").get<picojson::array>())
+    {
+      if (camera.is<picojson::object>()) preferences.emplace_back(camera.get<picojson::object>());
+    }
+    for (auto& preference : preferences) preference.buildShader();
+
+    // 展開用シェーダごとに最初の構成で計測する
+    std::set<GLuint> measured;
+    picojson::array results;
+    for (const auto& preference : preferences)
+    {
+      if (!measured.insert(preference.getShader().getProgram()).second) continue;
+
+      for (const auto& resolution : resolutions)
+      {
+        for (const auto samples : sampleCounts)
+        {
+          results.emplace_back(run(preference, resolution[0], resolution[1], samples, format, frames));
+        }
+      }
+    }
+
+    // 計測結果を格納する
+    setString(object, "renderer", reinterpret_cast<const char*>(glGetString(GL_RENDERER)));
+    setString(object, "version", reinterpret_cast<const char*>(glGetString(GL_VERSION)));
+    setString(object, "format", format == FrameFormat::YUYV ? "yuyv"
+      : format == FrameFormat::NV12 ? "nv12" : "interleaved");
+    setValue(object, "frames", frames);
+    object.emplace("results", results);
+  }
+
+  // 計測結果を書き出す
+  std::cout << picojson::value{ object }.serialize(true);
+
+  // 再利用のために保持している GPU の資源を削除して GLFW を終了する
+  ResourcePool::clear();
+  glfwDestroyWindow(window);
+  glfwTerminate();
+
+  return 0;
+}
+catch (const std::runtime_error& e)
+{
+  std::cerr << "bench_expand: " << e.what() << '\n';
+  return EXIT_FAILURE;
+}
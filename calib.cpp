@@ -24,19 +24,117 @@
 // フレームバッファオブジェクト
 #include "Framebuffer.h"
 
+// 処理時間の計測
+#include "Profiler.h"
+
+// 標準ライブラリ
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+
 // 構成ファイル名
 #define CONFIG_FILE PROJECT_NAME "_config.json"
 
+//
+// コマンドラインで指定する実行時のオプション
+//
+struct Options
+{
+  // ウィンドウを表示せず垂直同期も待たないなら true
+  bool headless{ false };
+
+  // 処理するフレーム数, 0 なら終了するまで処理する
+  unsigned long long frames{ 0 };
+
+  // ChArUco Board を検出するなら true
+  bool detectBoard{ false };
+
+  // ArUco Marker を検出するなら true
+  bool detectMarker{ false };
+
+  // 入力に使う画像ファイル名
+  std::string image;
+
+  // 入力に使う動画ファイル名
+  std::string movie;
+
+  // 終了時に処理時間の計測結果を保存するファイル名
+  std::string profile;
+
+  //
+  // 使い方を添えてコマンドラインの誤りを通知する
+  //
+  [[noreturn]] static void usage(const char* command, const std::string& message)
+  {
+    throw std::runtime_error(message + "\n"
+      "Usage: " + command + " [--headless] [--frames N] [--image FILE] [--movie FILE]"
+      " [--profile FILE] [--detect board|marker]");
+  }
+
+  //
+  // コマンドラインを解釈する
+  //
+  Options(int argc, const char* const* argv)
+  {
+    for (int i = 1; i < argc; ++i)
+    {
+      // オプション名
+      const std::string option{ argv[i] };
+
+      // 値をとらないオプション
+      if (option == "--headless")
+      {
+        headless = true;
+        continue;
+      }
+
+      // 値をとるオプションでなければ誤り
+      if (option != "--frames" && option != "--image" && option != "--movie"
+        && option != "--profile" && option != "--detect")
+        usage(argv[0], "Unknown option: " + option);
+
+      // 値がなければ誤り
+      if (++i >= argc) usage(argv[0], "Missing value for " + option);
+      const char* const value{ argv[i] };
+
+      if (option == "--frames")
+      {
+        // 符号や余分な文字を含まない範囲内の 10 進数でなければ誤り
+        char* end;
+        errno = 0;
+        frames = std::strtoull(value, &end, 10);
+        if (*value < '0' || *value > '9' || *end != '\0' || errno == ERANGE)
+          usage(argv[0], "Invalid value for " + option + ": " + value);
+      }
+      else if (option == "--image") image = value;
+      else if (option == "--movie") movie = value;
+      else if (option == "--profile") profile = value;
+      else
+      {
+        detectBoard = std::strcmp(value, "board") == 0;
+        detectMarker = std::strcmp(value, "marker") == 0;
+        if (!detectBoard && !detectMarker)
+          usage(argv[0], "Invalid value for " + option + ": " + value);
+      }
+    }
+  }
+};
+
 //
 // アプリケーション本体
 //
 int GgApp::main(int argc, const char* const* argv)
 {
+  // コマンドラインを解釈する
+  const Options options{ argc, argv };
+
   // 構成ファイルを読み込む
   Config config{ CONFIG_FILE };
 
   // 構成にもとづいてウィンドウを作成する
-  GgApp::Window window{ config.getTitle(), config.getWidth(), config.getHeight() };
+  GgApp::Window window{ config.getTitle(), config.getWidth(), config.getHeight(),
+    0, nullptr, options.headless };
 
   // 開いたウィンドウに対して初期化処理を実行する
   config.initialize();
@@ -45,85 +143,275 @@ int GgApp::main(int argc, const char* const* argv)
   Capture capture;
 
   // 較正オブジェクトを作成する
-  Calibration calibration{ config.getDictionaryName(), config.getCheckerLength() };
+  Calibration calibration{ config.getDictionaryName(), config.getCheckerLength(),
+    config.getBoardSquares(), config.getDetector() };
+
+  // 同時に検出する追加の較正板を設定する
+  calibration.setBoards(config.getBoards());
+
+  // 複数のカメラの較正オブジェクトを作成する
+  Rig rig{ calibration };
+
+  // 処理時間の計測オブジェクトを作成する
+  Profiler profiler;
 
   // メニューを作る
-  Menu menu{ config, capture, calibration };
+  Menu menu{ config, capture, calibration, rig, profiler };
 
-  // キャプチャデバイスで初期画像を開く
-  capture.openImage(config.getInitialImage());
+  // 入力に使うファイルが指定されていなければキャプチャデバイスで初期画像を開く
+  if (!options.movie.empty()) capture.openMovie(options.movie);
+  else capture.openImage(options.image.empty() ? config.getInitialImage() : options.image);
+
+  // 検出するものが指定されていれば検出する
+  menu.detectBoard = options.detectBoard;
+  menu.detectMarker = options.detectMarker;
+
+  // 計測結果を保存するなら最初から計測する
+  profiler.enabled = !options.profile.empty();
 
   // 解像度と画角の調整値の初期値を初期画像に合わせる
   menu.setSize(capture.getSize());
 
-  // キャプチャしたフレームを保持するテクスチャ
-  Texture frame;
+  // キャプチャデバイスごとにキャプチャしたフレームを保持するテクスチャ
+  std::deque<Frame> frames(1);
+
+  // キャプチャデバイスごとに画像の展開に用いるフレームバッファオブジェクト (検出するときにフレームに合わせて作る)
+  std::deque<Framebuffer> framebuffers;
+  framebuffers.emplace_back();
 
-  // 画像の展開に用いるフレームバッファオブジェクトのサイズを初期ウィンドウに合わせる
-  Framebuffer framebuffer{ config.getWidth(), config.getHeight() };
+  // 現在のフレームの表示方式 (ウィンドウの作成時の設定)
+  auto presentation{ options.headless ? Presentation::UNCAPPED : Presentation::VSYNC };
 
-  // ウィンドウが開いている間繰り返す
-  while (window && menu)
+  // フレームの到着を待つ最大の時間 (秒)
+  constexpr double frameTimeout{ 0.1 };
+
+  // 処理したフレーム数と処理を開始した時刻
+  unsigned long long frameCount{ 0 };
+  const auto startTime{ glfwGetTime() };
+
+  // ウィンドウが開いている間か指定したフレーム数に達するまで繰り返す
+  while (window && menu && (options.frames == 0 || frameCount < options.frames))
   {
     // メニューを表示して設定を更新する
     menu.draw();
 
-    // 選択しているキャプチャデバイスから１フレーム取得する
-    capture.retrieve(frame);
+    // フレームの表示方式が変更されたら (ヘッドレスモードでは垂直同期を待たない)
+    if (!options.headless && menu.getPresentation() != presentation)
+    {
+      // 新しい表示方式にする
+      presentation = menu.getPresentation();
+
+      // 垂直同期を待つのは VSYNC のときだけにする
+      window.setSwapInterval(presentation == Presentation::VSYNC ? 1 : 0);
+
+      // ON_FRAME ならフレームが到着するか入力イベントが発生するまで待つ
+      window.setWaitTimeout(presentation == Presentation::ON_FRAME ? frameTimeout : -1.0);
+    }
+
+    // すべてのキャプチャデバイスから時刻の揃ったフレームを取得する
+    bool received;
+    {
+      Profiler::Scope scope{ profiler, "transmit", true };
+      received = capture.retrieve(frames);
+    }
+
+    // 新しいフレームを取得していれば取得してから転送を終えるまでの遅延を記録する
+    if (received)
+    {
+      for (const auto& frame : frames)
+        if (frame.getTimestamp() >= 0.0) profiler.addLatency("capture-transmit", glfwGetTime() - frame.getTimestamp());
+    }
+
+    // 展開と検出に用いる設定の版
+    const auto revision{ menu.getRevision() };
 
-    // ピクセルバッファオブジェクトの内容をテクスチャに転送する
-    frame.drawPixels();
+    // フレームバッファオブジェクトの数をフレームの数に合わせる
+    while (framebuffers.size() < frames.size())
+      framebuffers.emplace_back();
+    while (framebuffers.size() > frames.size()) framebuffers.pop_back();
 
-    // フレームバッファオブジェクトのサイズをキャプチャしたフレームに合わせる
-    framebuffer.resize(frame);
+    // 較正オブジェクトの数をフレームの数に合わせる
+    rig.resize(frames.size());
 
-    // シェーダの設定を行う
-    const auto&& size{ menu.setup(framebuffer.getAspect()) };
+    // 読み出しを開始して検出を待っているフレームの番号
+    std::vector<size_t> detecting;
 
-    // フレームバッファオブジェクトにフレームを展開する
-    framebuffer.update(size, frame);
+    // すべてのフレームについて
+    for (size_t i = 0; i < frames.size(); ++i)
+    {
+      // キャプチャしたフレームと展開先のフレームバッファオブジェクト
+      auto& frame{ frames[i] };
+      auto& framebuffer{ framebuffers[i] };
 
-    // ArUco Marker を検出するなら
-    if (menu.detectMarker || menu.detectBoard)
+      // 新しいフレームを取得していればピクセルバッファオブジェクトの内容をテクスチャに転送する
+      if (received)
+      {
+        Profiler::Scope scope{ profiler, "drawPixels", true };
+        frame.drawPixels();
+      }
+
+      // ChArUco Board を検出せず選択しているキャプチャデバイスのフレームで ArUco Marker も検出しないなら
+      if (!menu.detectBoard && !(i == 0 && menu.detectMarker))
+      {
+        // 読み出す必要がなく表示するときに直接展開するのでフレームバッファオブジェクトは使わない
+        if (framebuffer.getFramebufferName() != 0) framebuffer = Framebuffer{};
+        continue;
+      }
+
+      // フレームバッファオブジェクトのサイズをキャプチャしたフレームに合わせる
+      framebuffer.resize(frame);
+
+      // フレームも設定も変わらず作り直してもいなければ展開済みの内容をそのまま使う
+      if (!received && framebuffer.getRevision() == revision) continue;
+
+      // シェーダの設定を行う
+      const auto&& size{ menu.setup(framebuffer.getAspect(), frame.getFrameFormat()) };
+
+      // フレームバッファオブジェクトにフレームを展開する
+      {
+        Profiler::Scope scope{ profiler, "update", true };
+        framebuffer.update(size, frame);
+      }
+
+      // フレームバッファオブジェクトの内容のピクセルバッファオブジェクトへの読み出しを開始する
+      {
+        Profiler::Scope scope{ profiler, "readPixels", true };
+        framebuffer.readPixels();
+      }
+      detecting.emplace_back(i);
+
+      // 展開した内容の版を記録する
+      framebuffer.setRevision(revision);
+    }
+
+    // 読み出しを開始したフレームについて (読み出しは後に続くキャプチャデバイスのフレームの展開や検出と並行して進む)
+    for (const auto i : detecting)
     {
-      // フレームバッファオブジェクトの内容をピクセルバッファオブジェクトに転送する
-      framebuffer.readPixels();
+      // キャプチャしたフレームと展開先のフレームバッファオブジェクト
+      const auto& frame{ frames[i] };
+      auto& framebuffer{ framebuffers[i] };
 
       // 入力画像のサイズを調べる
       const auto size{ cv::Size{ framebuffer.getWidth(), framebuffer.getHeight() } };
 
       // ピクセルバッファオブジェクトを CPU のメモリ空間にマップする
-      cv::Mat image{ size, CV_8UC(framebuffer.getChannels()), framebuffer.map() };
+      GLvoid* pixels;
+      {
+        Profiler::Scope scope{ profiler, "map" };
+        pixels = framebuffer.map();
+      }
+      cv::Mat image{ size, CV_8UC(framebuffer.getChannels()), pixels };
+
+      // RGBA で読み出していたら検出と描き込みのために 3 チャネルを取り出す
+      cv::Mat extracted;
+      if (image.channels() == 4) cv::cvtColor(image, extracted, cv::COLOR_BGRA2BGR);
+      auto& target{ image.channels() == 4 ? extracted : image };
 
       // ChArUco Board を認識するなら
       if (menu.detectBoard)
       {
-        // ChArUco Board を検出する
-        calibration.detectBoard(image);
+        // このキャプチャデバイスの較正オブジェクトで ChArUco Board を検出する
+        Profiler::Scope scope{ profiler, "detect" };
+        rig.get(i).detectBoard(target, frame.getSequence(), menu.getExpansionRevision());
       }
       else
       {
         // ArUco Marker を検出する
-        calibration.detectMarkers(image, menu.getMarkerLength());
+        Profiler::Scope scope{ profiler, "detect" };
+        calibration.detectMarkers(target, menu.getMarkerLength(),
+          frame.getSequence(), menu.getExpansionRevision());
       }
 
+      // 新しいフレームなら取得してから検出を終えるまでの遅延を記録する
+      if (received && frame.getTimestamp() >= 0.0)
+        profiler.addLatency("capture-detect", glfwGetTime() - frame.getTimestamp());
+
+      // 取り出した 3 チャネルに描き込んだ結果を RGBA に戻す
+      if (image.channels() == 4) cv::cvtColor(extracted, image, cv::COLOR_BGR2BGRA);
+
       // ピクセルバッファオブジェクトのマップを解除する
       framebuffer.unmap();
 
       // ピクセルバッファオブジェクトの内容をフレームバッファオブジェクトに書き戻す
-      framebuffer.drawPixels();
+      {
+        Profiler::Scope scope{ profiler, "writeBack", true };
+        framebuffer.drawPixels();
+      }
     }
 
     // 表示するウィンドウのビューポートを再設定する
     window.setMenubarHeight(menu.getMenubarHeight());
 
-    // フレームバッファオブジェクトの内容を表示する
-    //framebuffer.show(window.getWidth(), window.getHeight());
-    framebuffer.draw(window.getWidth(), window.getHeight());
+    // フレームをキャプチャデバイスごとに並べて表示する
+    for (size_t i = 0; i < framebuffers.size(); ++i)
+    {
+      // フレームバッファオブジェクトを使っていなければ
+      if (framebuffers[i].getFramebufferName() == 0)
+      {
+        // 上下を反転するようにシェーダの設定を行ってフレームを表示領域に直接展開する
+        Profiler::Scope scope{ profiler, "update", true };
+        const auto&& size{ menu.setup(frames[i].getAspect(), frames[i].getFrameFormat(), true) };
+        frames[i].expand(size, static_cast<int>(i), static_cast<int>(frames.size()));
+      }
+      else
+      {
+        // フレームバッファオブジェクトの内容を表示する
+        //framebuffers[i].show(window.getWidth(), window.getHeight());
+        framebuffers[i].draw(window.getWidth(), window.getHeight(),
+          static_cast<int>(i), static_cast<int>(framebuffers.size()));
+      }
+    }
 
     // カラーバッファを入れ替えてイベントを取り出す
-    window.swapBuffers();
+    {
+      Profiler::Scope scope{ profiler, "swapBuffers" };
+      window.swapBuffers();
+    }
+
+    // 新しいフレームを表示したら取得してから表示するまでの遅延を記録する
+    if (received)
+    {
+      for (const auto& frame : frames)
+        if (frame.getTimestamp() >= 0.0) profiler.addLatency("capture-present", glfwGetTime() - frame.getTimestamp());
+    }
+
+    // このフレームの計測を終える
+    profiler.nextFrame();
+
+    // 処理したフレーム数を数える
+    ++frameCount;
+  }
+
+  // ヘッドレスモードなら処理速度を報告する
+  if (options.headless)
+  {
+    const auto elapsed{ glfwGetTime() - startTime };
+    std::cerr << frameCount << " frames in " << elapsed << " s ("
+      << (elapsed > 0.0 ? frameCount / elapsed : 0.0) << " fps), "
+      << capture.getDroppedFrames() << " dropped\n";
+
+    // 遅延の百分位数を報告する
+    for (size_t i = 0; i < profiler.getLatencyCount(); ++i)
+    {
+      const auto percentiles{ profiler.getLatencyPercentiles(i) };
+      std::cerr << profiler.getLatencyName(i) << ": p50 " << percentiles[0]
+        << " ms, p95 " << percentiles[1] << " ms, p99 " << percentiles[2] << " ms\n";
+    }
+  }
+
+  // 指定されていれば処理時間の計測結果を保存する
+  if (!options.profile.empty())
+  {
+    const auto& name{ options.profile };
+    const bool csv{ name.size() >= 4 && name.compare(name.size() - 4, 4, ".csv") == 0 };
+    if (!(csv ? profiler.saveCsv(name) : profiler.saveTrace(name)))
+      std::cerr << "Cannot save " << name << "\n";
   }
 
+  // ウィンドウを閉じる前にフレームを破棄して再利用のために保持している GPU の資源を削除する
+  frames.clear();
+  framebuffers.clear();
+  ResourcePool::clear();
+
   return 0;
 }
@@ -4,8 +4,8 @@
 // 正距円筒図法画像のサンプリング
 //
 
-// テクスチャ
-uniform sampler2D image;
+// テクスチャをサンプリングして BGR の順に並べた画素色を返す関数 sampleImage() と
+// そのサンプラなどの uniform 変数は、読み込み時に sample.glsl を挿入して定義する
 
 // テクスチャ上の投影像の半径と中心位置
 uniform vec4 circle;
@@ -28,5 +28,5 @@ void main(void)
   vec2 texcoord = atan(vector.xy, vec2(vector.z, length(vector.xz))) * scale + center;
 
   // 画素の陰影を求める
-  fc = texture(image, texcoord);
+  fc = sampleImage(texcoord);
 }
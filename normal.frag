@@ -4,8 +4,8 @@
 // テクスチャ座標の位置の画素色をそのまま使う
 //
 
-// テクスチャ
-uniform sampler2D image;
+// テクスチャをサンプリングして BGR の順に並べた画素色を返す関数 sampleImage() と
+// そのサンプラなどの uniform 変数は、読み込み時に sample.glsl を挿入して定義する
 
 // 境界色
 uniform vec4 border;
@@ -22,5 +22,5 @@ void main(void)
   vec4 code = vec4(texcoord, 1.0 - texcoord);
 
   // テクスチャ座標の範囲外は境界色にする
-  fc = all(greaterThan(code, vec4(0.0))) ? texture(image, texcoord) : border.bgra;
+  fc = all(greaterThan(code, vec4(0.0))) ? sampleImage(texcoord) : border.bgra;
 }
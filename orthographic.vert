@@ -19,6 +19,9 @@ uniform mat4 rotation;
 // スクリーンの格子間隔
 uniform vec2 gap;
 
+// 表示領域に直接描くときは上下を反転する
+uniform bool flip;
+
 // テクスチャ座標
 out vec2 texcoord;
 
@@ -36,7 +39,9 @@ void main(void)
   vec2 position = vec2(x, y) * gap - 1.0;
 
   // 頂点位置をそのままラスタライザに送ればクリッピング空間全面に描く
-  gl_Position = vec4(position, 0.0, 1.0);
+  //   フレームバッファオブジェクトには読み出したときに画像の上端が先頭の行になるように描くので、
+  //   表示領域に直接描くときは上下を反転する。
+  gl_Position = vec4(position.x, flip ? -position.y : position.y, 0.0, 1.0);
 
   // スクリーン上の位置 (screen の縦と横を入れ替えている)
   vec2 p = mat2(rotation) * position * screen.ts + screen.pq;
@@ -0,0 +1,31 @@
+//
+// 展開用フラグメントシェーダに共通のテクスチャのサンプリング
+//
+//   Expand クラスが展開用フラグメントシェーダを読み込むときに
+//   #version 指令の直後に挿入する
+//
+
+// テクスチャ
+uniform sampler2D image;
+
+// 色差のテクスチャ
+uniform sampler2D chroma;
+
+// 画素の格納形式 (0: BGR, 1: YUYV, 2: NV12)
+uniform int format;
+
+// テクスチャをサンプリングして BGR の順に並べた画素色を返す
+vec4 sampleImage(in vec2 t)
+{
+  // 画素ごとにチャネルを並べた形式ならそのまま返す
+  if (format == 0) return texture(image, t);
+
+  // 輝度と色差を取り出す (ITU-R BT.601, 限定範囲)
+  float y = 1.164 * (texture(image, t).r - 0.0625);
+  vec4 c = texture(chroma, t);
+  vec2 uv = (format == 1 ? c.ga : c.rg) - 0.5;
+
+  // RGB に変換して BGR の順に並べる
+  vec3 rgb = y + vec3(1.596 * uv.y, -0.392 * uv.x - 0.813 * uv.y, 2.017 * uv.x);
+  return vec4(clamp(rgb.bgr, 0.0, 1.0), 1.0);
+}
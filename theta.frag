@@ -4,8 +4,8 @@
 // RICOH THETA S の二重魚眼画像の平面展開
 //
 
-// テクスチャ
-uniform sampler2D image;
+// テクスチャをサンプリングして BGR の順に並べた画素色を返す関数 sampleImage() と
+// そのサンプラなどの uniform 変数は、読み込み時に sample.glsl を挿入して定義する
 
 // テクスチャ座標
 in vec2 texcoord_b;
@@ -20,8 +20,8 @@ layout (location = 0) out vec4 fc;
 void main(void)
 {
   // 前後のテクスチャの色をサンプリングする
-  vec4 color_b = texture(image, texcoord_b);
-  vec4 color_f = texture(image, texcoord_f);
+  vec4 color_b = sampleImage(texcoord_b);
+  vec4 color_f = sampleImage(texcoord_f);
 
   // サンプリングした色をブレンドしてフラグメントの色を求める
   fc = mix(color_f, color_b, blend);